@@ -1,23 +1,78 @@
 #include "BigInteger.h"
+#include "BigIntegerKernels.h"
+#include "BigIntegerMontgomery.h"
+#include "BigIntegerRandom.h"
 
 #include <iostream>
 #include <cmath>
 #include <algorithm>
 #include <cassert>
-#include <random>
+#include <limits>
 #include <functional>
 
-BigInt::BigInteger::BigInteger() {
-    this -> sign = PLUS;
-    this -> data = std::vector<int>();
+namespace {
+    int compareMagnitude(const BigInt::LimbBuffer &lhs, const BigInt::LimbBuffer &rhs) {
+        if (lhs.size() != rhs.size()) {
+            return lhs.size() < rhs.size() ? -1 : 1;
+        }
+        return BigInt::mpn::compare(lhs.data(), rhs.data(), lhs.size());
+    }
+
+    // Multiplies the magnitude by a single limb and adds another one in place.
+    void mulAddLimb(BigInt::LimbBuffer &data, BigInt::limb_t mult, BigInt::limb_t add) {
+        BigInt::limb_t carry = BigInt::mpn::mul1(data.data(), data.data(), data.size(), mult);
+        data.push_back(carry);
+        if (BigInt::mpn::add(data.data(), data.data(), data.size(), &add, 1)) {
+            data.push_back(1);
+        }
+        data.resize(BigInt::mpn::normalizedSize(data.data(), data.size()));
+    }
+
+    // Workspace of the span products, kept per thread, so a product below the Toom-3 size
+    // allocates nothing besides its result
+    BigInt::limb_t *productWorkspace(size_t n) {
+        static thread_local std::vector<BigInt::limb_t> workspace;
+        if (workspace.size() < n) {
+            workspace.resize(n);
+        }
+        return workspace.data();
+    }
+
+    void multiplySpans(BigInt::limb_t *r, const BigInt::limb_t *a, size_t an, const BigInt::limb_t *b, size_t bn) {
+        BigInt::mpn::mul(r, a, an, b, bn, productWorkspace(BigInt::mpn::mulScratchSize(an, bn)));
+    }
+
+    void squareSpan(BigInt::limb_t *r, const BigInt::limb_t *a, size_t n) {
+        BigInt::mpn::sqr(r, a, n, productWorkspace(BigInt::mpn::sqrScratchSize(n)));
+    }
+
+    // The product can't overlap its factors, so fused operations form it in per-thread scratch.
+    // Returns the length of the product without leading zero limbs.
+    size_t multiplyIntoScratch(std::vector<BigInt::limb_t> &product,
+                               const BigInt::LimbBuffer &a, const BigInt::LimbBuffer &b) {
+        if (a.empty() || b.empty()) {
+            return 0;
+        }
+        product.resize(a.size() + b.size());
+        if (&a == &b) {
+            squareSpan(product.data(), a.data(), a.size());
+        } else if (a.size() >= b.size()) {
+            multiplySpans(product.data(), a.data(), a.size(), b.data(), b.size());
+        } else {
+            multiplySpans(product.data(), b.data(), b.size(), a.data(), a.size());
+        }
+        return BigInt::mpn::normalizedSize(product.data(), product.size());
+    }
+
+    std::vector<BigInt::limb_t> &productScratch() {
+        static thread_local std::vector<BigInt::limb_t> product;
+        return product;
+    }
+
 }
 
-BigInt::BigInteger::BigInteger(int x) {
-    this -> sign = x >= 0 ? PLUS : MINUS;
-    this -> data = std::vector<int>();
-    this -> data.push_back(std::abs(x) % MODULO);
-    this -> data.push_back(std::abs(x) / MODULO);
-    this -> cleanup_zeroes();
+BigInt::BigInteger::BigInteger() {
+    this -> sign = PLUS;
 }
 
 BigInt::BigInteger BigInt::BigInteger::operator+() const {
@@ -37,6 +92,33 @@ BigInt::BigInteger BigInt::BigInteger::abs() const {
     return result;
 }
 
+int BigInt::BigInteger::compareAbs(const BigInt::BigInteger &rhs) const {
+    return compareMagnitude(data, rhs.data);
+}
+
+int BigInt::BigInteger::compare(const BigInt::BigInteger &rhs) const {
+    if (sign != rhs.sign) {
+        return sign == MINUS ? -1 : 1;
+    }
+    int cmp = compareMagnitude(data, rhs.data);
+    return sign == PLUS ? cmp : -cmp;
+}
+
+bool BigInt::BigInteger::isZero() const {
+    return data.empty();
+}
+
+bool BigInt::BigInteger::isOne() const {
+    return sign == PLUS && data.size() == 1 && data[0] == 1;
+}
+
+int BigInt::BigInteger::signum() const {
+    if (data.empty()) {
+        return 0;
+    }
+    return sign == PLUS ? 1 : -1;
+}
+
 bool BigInt::BigInteger::operator==(const BigInt::BigInteger &rhs) const {
     return (sign == rhs.sign && data == rhs.data);
 }
@@ -46,94 +128,105 @@ bool BigInt::BigInteger::operator!=(const BigInt::BigInteger &rhs) const {
 }
 
 bool BigInt::BigInteger::operator<(const BigInt::BigInteger &rhs) const {
-    if (sign != rhs.sign) {
-        return sign == MINUS;
-    }
-    int len1 = data.size();
-    int len2 = rhs.data.size();
-    if (len1 != len2) {
-        return sign == PLUS ? len1 < len2 : len1 > len2;
-    }
-    for (auto pos1 = data.end() - 1, pos2 = rhs.data.end() - 1; pos1 >= data.begin(); pos1--, pos2--) {
-        if (*pos1 != *pos2) {
-            return sign == PLUS ? *pos1 < *pos2 : *pos1 > *pos2;
-        }
-    }
-    return false;
+    return compare(rhs) < 0;
 }
 
 bool BigInt::BigInteger::operator>(const BigInt::BigInteger &rhs) const {
-    return !((*this) == rhs) && !((*this) < rhs);
+    return compare(rhs) > 0;
 }
 
 bool BigInt::BigInteger::operator<=(const BigInt::BigInteger &rhs) const {
-    return ((*this) == rhs || (*this) < rhs);
+    return compare(rhs) <= 0;
 }
 
 bool BigInt::BigInteger::operator>=(const BigInt::BigInteger &rhs) const {
-    return ((*this) == rhs || (*this) > rhs);
+    return compare(rhs) >= 0;
 }
 
-BigInt::BigInteger BigInt::BigInteger::operator+(const BigInteger& rhs) const {
-    BigInt::BigInteger result;
-    if (this -> sign == rhs.sign) {
-        auto pos1 = this -> data.begin();
-        auto pos2 = rhs.data.begin();
-        int rem = 0;
-        while (pos1 != this -> data.end() || pos2 != rhs.data.end() || rem > 0) {
-            int left_add = pos1 != this -> data.end() ? *pos1 : 0;
-            int right_add = pos2 != rhs.data.end() ? *pos2 : 0;
-            int cur_res = left_add + right_add + rem;
-
-            rem = cur_res / MODULO;
-            result.data.push_back(cur_res % MODULO);
-
-            if (pos1 != this -> data.end()) pos1++;
-            if (pos2 != rhs.data.end()) pos2++;
-        }
-        result.sign = this -> sign;
-    } else {
-        BigInt::BigInteger smaller, bigger;
-        if ((*this).abs() < rhs.abs()) {
-            smaller = *this;
-            bigger = rhs;
-        } else {
-            smaller = rhs;
-            bigger = *this;
+void BigInt::BigInteger::add_signed(const limb_t *b, size_t bn, BigIntegerSign bSign) {
+    if (bn == 0) {
+        return;
+    }
+    if (data.empty()) {
+        data.assign(b, b + bn);
+        sign = bSign;
+        return;
+    }
+    size_t n = data.size();
+    if (sign == bSign) {
+        if (n < bn) {
+            data.resize(bn, 0);
         }
-        auto pos1 = bigger.data.begin();
-        auto pos2 = smaller.data.begin();
-        int rem = 0;
-        while (pos1 != bigger.data.end() || pos2 != smaller.data.end() || rem > 0) {
-            int left_operand = pos1 != bigger.data.end() ? *pos1 : 0;
-            int right_operand = pos2 != smaller.data.end() ? *pos2 : 0;
-            int cur_res = left_operand - right_operand - rem;
-
-            if (cur_res >= 0) {
-                rem = 0;
-                result.data.push_back(cur_res);
-            } else {
-                rem = (std::abs(cur_res) + MODULO - 1) / MODULO;
-                result.data.push_back(cur_res + rem * MODULO);
-            }
-
-            if (pos1 != bigger.data.end()) pos1++;
-            if (pos2 != smaller.data.end()) pos2++;
+        if (mpn::add(data.data(), data.data(), data.size(), b, bn)) {
+            data.push_back(1);
         }
-        result.sign = bigger.sign;
-        result.cleanup_zeroes();
+    } else if (n > bn || (n == bn && mpn::compare(data.data(), b, n) >= 0)) {
+        mpn::sub(data.data(), data.data(), n, b, bn);
+        cleanup_zeroes();
+    } else {
+        // |b| is bigger, so the difference is taken the other way round and gets the sign of b
+        data.resize(bn, 0);
+        mpn::sub(data.data(), b, bn, data.data(), bn);
+        sign = bSign;
+        cleanup_zeroes();
     }
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator+(const BigInteger& rhs) const & {
+    BigInt::BigInteger result;
+    result.data.reserve(std::max(data.size(), rhs.data.size()) + 1);
+    result.data.assign(data.begin(), data.end());
+    result.sign = sign;
+    result += rhs;
     return result;
 }
 
-BigInt::BigInteger BigInt::BigInteger::operator-(const BigInteger& rhs) const {
-    return (*this) + (-rhs);
+BigInt::BigInteger BigInt::BigInteger::operator+(const BigInteger& rhs) && {
+    *this += rhs;
+    return std::move(*this);
 }
 
-void BigInt::BigInteger::cleanup_zeroes() {
-    while (!data.empty() && data.back() == 0) {
-        data.pop_back();
+BigInt::BigInteger BigInt::BigInteger::operator+(BigInteger&& rhs) const & {
+    rhs += *this;
+    return std::move(rhs);
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator+(BigInteger&& rhs) && {
+    *this += rhs;
+    return std::move(*this);
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator-(const BigInteger& rhs) const & {
+    BigInt::BigInteger result;
+    result.data.reserve(std::max(data.size(), rhs.data.size()) + 1);
+    result.data.assign(data.begin(), data.end());
+    result.sign = sign;
+    result -= rhs;
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator-(const BigInteger& rhs) && {
+    *this -= rhs;
+    return std::move(*this);
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator-(BigInteger&& rhs) const & {
+    if (&rhs == this) {
+        return BigInteger();
     }
+    rhs.inverse_sign();
+    rhs.cleanup_zeroes();
+    rhs += *this;
+    return std::move(rhs);
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator-(BigInteger&& rhs) && {
+    *this -= rhs;
+    return std::move(*this);
+}
+
+void BigInt::BigInteger::cleanup_zeroes() {
+    data.resize(mpn::normalizedSize(data.data(), data.size()));
     if (data.empty()) {
         sign = PLUS;
     }
@@ -148,22 +241,7 @@ void BigInt::BigInteger::inverse_sign() {
 }
 
 std::ostream& BigInt::operator<<(std::ostream &os, const BigInt::BigInteger &rhs) {
-    if (rhs.sign == MINUS) {
-        os << '-';
-    }
-    if (rhs.data.empty()) {
-        os << 0;
-    }
-    for (auto it = rhs.data.end() - 1; it >= rhs.data.begin(); it--) {
-        std::string current_str = std::to_string(*it);
-        if (it != rhs.data.end() - 1) {
-            while (current_str.length() < BigInt::BigInteger::CELL_LENGTH) {
-                current_str = '0' + current_str; // NOLINT(performance-inefficient-string-concatenation)
-            }
-        }
-        os << current_str;
-    }
-    return os;
+    return os << rhs.toString();
 }
 
 BigInt::BigInteger::BigInteger(const std::string& s) {
@@ -180,22 +258,13 @@ BigInt::BigInteger::BigInteger(const std::string& s) {
     } else {
         sign = PLUS;
     }
-    int current_num = 0, current_pow = 1;
-    for (auto it = s.end() - 1; it >= pos; it--) {
-        if (current_pow == MODULO) {
-            data.push_back(current_num);
-            current_num = 0;
-            current_pow = 1;
-        }
-        if (!isdigit(*it)) {
-            throw InvalidBigIntegerStringException();
-        }
-        current_num += current_pow * int(*it - '0');
-        current_pow *= 10;
-    }
-    if (current_num > 0) {
-        data.push_back(current_num);
+    if (pos == s.end() || !std::all_of(pos, s.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        throw InvalidBigIntegerStringException();
     }
+    size_t length = s.end() - pos;
+    data.resize(length / detail::DECIMAL_CELL_LENGTH + 1);
+    data.resize(detail::fromDecimal(data.data(), &*pos, length));
+    cleanup_zeroes();
 }
 
 std::istream& BigInt::operator>>(std::istream &is, BigInt::BigInteger &rhs) {
@@ -205,40 +274,18 @@ std::istream& BigInt::operator>>(std::istream &is, BigInt::BigInteger &rhs) {
     return is;
 }
 
-BigInt::BigInteger BigInt::BigInteger::operator*(const BigInt::BigInteger &rhs) const {
-    BigInt::BigInteger result;
-
-    std::vector<long long> result_vec;
-    std::vector<BigInt::fft_base> left_arg(data.begin(), data.end()), right_arg(rhs.data.begin(), rhs.data.end());
-    size_t n = 1;
-    while (n < std::max(data.size(), rhs.data.size())) {
-        n *= 2;
-    }
-    n *= 2;
-    left_arg.resize(n);
-    right_arg.resize(n);
-    BigInt::fft(left_arg, false);
-    BigInt::fft(right_arg, false);
-    for (size_t i = 0; i < n; i++) {
-        left_arg[i] *= right_arg[i];
-    }
-    BigInt::fft(left_arg, true);
-    result_vec.resize(n);
-    for (size_t i = 0; i < n; i++) {
-        result_vec[i] = (long long)(floor(left_arg[i].real() + 0.5));
+BigInt::BigInteger BigInt::BigInteger::operator*(const BigInt::BigInteger &rhs) const & {
+    if (&rhs == this) {
+        return square();
     }
-    int rem = 0;
-    auto pos = result_vec.begin();
-    while (rem > 0 || pos != result_vec.end())
-    {
-        long long add = (pos != result_vec.end() ? *pos : 0);
-        long long cur_res = add + rem;
-
-        result.data.push_back(cur_res % MODULO);
-        rem = cur_res / MODULO;
-
-        if (pos != result_vec.end()) pos++;
+    BigInt::BigInteger result;
+    if (data.empty() || rhs.data.empty()) {
+        return result;
     }
+    const LimbBuffer &longer = data.size() >= rhs.data.size() ? data : rhs.data;
+    const LimbBuffer &shorter = data.size() >= rhs.data.size() ? rhs.data : data;
+    result.data.resize(longer.size() + shorter.size());
+    multiplySpans(result.data.data(), longer.data(), longer.size(), shorter.data(), shorter.size());
 
     if (sign == rhs.sign) {
         result.sign = PLUS;
@@ -250,128 +297,391 @@ BigInt::BigInteger BigInt::BigInteger::operator*(const BigInt::BigInteger &rhs)
     return result;
 }
 
-BigInt::BigInteger BigInt::BigInteger::pow(BigInt::BigInteger exp, const BigInteger& modulo) const {
-    BigInt::BigInteger mult = *this;
-    BigInt::BigInteger result = BigInteger(1);
-    while (exp != BigInteger(0)) {
-        if (exp.data[0] % 2 == 1) {
-            result *= mult;
-            if (modulo != BigInteger(0)) {
-                result %= modulo;
-            }
-        }
-        mult *= mult;
-        if (modulo != BigInteger(0)) {
-            mult %= modulo;
-        }
-        exp /= BigInteger(2);
+BigInt::BigInteger BigInt::BigInteger::operator*(const BigInt::BigInteger &rhs) && {
+    *this *= rhs;
+    return std::move(*this);
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator*(BigInt::BigInteger &&rhs) const & {
+    rhs *= *this;
+    return std::move(rhs);
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator*(BigInt::BigInteger &&rhs) && {
+    *this *= rhs;
+    return std::move(*this);
+}
+
+BigInt::BigInteger BigInt::BigInteger::square() const {
+    BigInt::BigInteger result;
+    if (data.empty()) {
+        return result;
     }
+    result.data.resize(2 * data.size());
+    squareSpan(result.data.data(), data.data(), data.size());
+    result.cleanup_zeroes();
     return result;
 }
 
+BigInt::BigInteger BigInt::BigInteger::pow(BigInt::BigInteger exp, const BigInteger& modulo) const {
+    // Odd moduli are reduced by REDC instead of a division after every product
+    if (modulo.sign == PLUS && modulo.isOdd() && !modulo.isOne() && exp.signum() > 0) {
+        return MontgomeryContext(modulo).modPow(*this, exp);
+    }
+    if (exp.signum() <= 0) {
+        return BigInteger(1);
+    }
+    if (modulo.data.empty()) {
+        return detail::windowPow(*this, exp,
+                                 [](BigInteger &x, const BigInteger &y) { x *= y; },
+                                 [](BigInteger &x) { x *= x; });
+    }
+    return detail::windowPow(*this % modulo, exp,
+                             [&modulo](BigInteger &x, const BigInteger &y) { x.mulMod(y, modulo); },
+                             [&modulo](BigInteger &x) { x.mulMod(x, modulo); });
+}
+
 BigInt::BigInteger &BigInt::BigInteger::operator*=(const BigInt::BigInteger &rhs) {
-    BigInt::BigInteger result = (*this) * rhs;
-    this -> sign = result.sign;
-    this -> data = result.data;
+    // The product is copied back into the capacity this number already has
+    std::vector<limb_t> &product = productScratch();
+    size_t n = multiplyIntoScratch(product, data, rhs.data);
+    sign = sign == rhs.sign ? PLUS : MINUS;
+    data.assign(product.begin(), product.begin() + n);
+    cleanup_zeroes();
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::addMul(const BigInt::BigInteger &a, const BigInt::BigInteger &b) {
+    std::vector<limb_t> &product = productScratch();
+    size_t n = multiplyIntoScratch(product, a.data, b.data);
+    add_signed(product.data(), n, a.sign == b.sign ? PLUS : MINUS);
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::subMul(const BigInt::BigInteger &a, const BigInt::BigInteger &b) {
+    std::vector<limb_t> &product = productScratch();
+    size_t n = multiplyIntoScratch(product, a.data, b.data);
+    add_signed(product.data(), n, a.sign == b.sign ? MINUS : PLUS);
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::mulMod(const BigInt::BigInteger &rhs, const BigInt::BigInteger &modulo) {
+    std::vector<limb_t> &product = productScratch();
+    size_t n = multiplyIntoScratch(product, data, rhs.data);
+    divide(product.data(), n, n == 0 || sign == rhs.sign ? PLUS : MINUS, modulo, nullptr, this);
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::addMod(const BigInt::BigInteger &rhs, const BigInt::BigInteger &modulo) {
+    *this += rhs;
+    reduce_once(modulo);
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::subMod(const BigInt::BigInteger &rhs, const BigInt::BigInteger &modulo) {
+    *this -= rhs;
+    reduce_once(modulo);
     return *this;
 }
 
+void BigInt::BigInteger::reduce_once(const BigInt::BigInteger &modulo) {
+    if (modulo.sign == PLUS) {
+        if (sign == MINUS) {
+            *this += modulo;
+        } else if (*this >= modulo) {
+            *this -= modulo;
+        }
+        if (sign == PLUS && *this < modulo) {
+            return;
+        }
+    }
+    *this %= modulo;
+}
+
 BigInt::BigInteger BigInt::BigInteger::getIntOfLen(int len) {
     BigInt::BigInteger res(1);
     return res.scale(len - 1);
 }
 
-BigInt::BigInteger BigInt::BigInteger::operator/(const BigInt::BigInteger &rhs) const {
-    std::vector<int> resultVec;
+void BigInt::BigInteger::divide(const BigInt::BigInteger &lhs, const BigInt::BigInteger &rhs,
+                                BigInt::BigInteger *quotient, BigInt::BigInteger *remainder) {
+    divide(lhs.data.data(), lhs.data.size(), lhs.sign, rhs, quotient, remainder);
+}
 
-    if (this->data.size() < rhs.data.size())
-        resultVec = std::vector<int>(0, 1);
-    else {
+void BigInt::BigInteger::divide(const limb_t *a, size_t an, BigIntegerSign aSign, const BigInt::BigInteger &rhs,
+                                BigInt::BigInteger *quotient, BigInt::BigInteger *remainder) {
+    if (rhs.data.empty()) {
+        throw DivisionByZeroException();
+    }
+    static thread_local std::vector<limb_t> q, r;
+    size_t n = rhs.data.size();
+    if (an >= n) {
+        q.resize(an - n + 1);
+        r.resize(n);
+        mpn::divRem(q.data(), r.data(), a, an, rhs.data.data(), n);
+    } else {
+        q.clear();
+        r.assign(a, a + an);
+    }
+    r.resize(mpn::normalizedSize(r.data(), r.size()));
+    BigIntegerSign quotientSign = aSign == rhs.sign ? PLUS : MINUS;
+    BigIntegerSign remainderSign = rhs.sign;
+    // Quotients are rounded towards minus infinity
+    if (quotientSign == MINUS && !r.empty()) {
+        limb_t one = 1;
+        q.push_back(0);
+        mpn::add(q.data(), q.data(), q.size(), &one, 1);
+        r.resize(n, 0);
+        mpn::sub(r.data(), rhs.data.data(), n, r.data(), n);
+    }
+    // Results are written last, since they may share storage with the operands
+    if (quotient != nullptr) {
+        quotient->data.assign(q.begin(), q.end());
+        quotient->sign = quotientSign;
+        quotient->cleanup_zeroes();
+    }
+    if (remainder != nullptr) {
+        remainder->data.assign(r.begin(), r.end());
+        remainder->sign = remainderSign;
+        remainder->cleanup_zeroes();
+    }
+}
 
-        BigInt::BigInteger curPow = getIntOfLen(this->data.size() - rhs.data.size() + 1);
-        BigInt::BigInteger currentSum = BigInteger(0);
+std::pair<BigInt::BigInteger, BigInt::BigInteger> BigInt::divmod(const BigInt::BigInteger &lhs,
+                                                                   const BigInt::BigInteger &rhs) {
+    std::pair<BigInt::BigInteger, BigInt::BigInteger> result;
+    BigInt::BigInteger::divide(lhs, rhs, &result.first, &result.second);
+    return result;
+}
 
-        while (curPow != BigInteger(0)) {
-            int lower_bound = 0, upper_bound = MODULO - 1;
-            while (upper_bound != lower_bound) {
-                int middle = (lower_bound + upper_bound + 1) / 2;
-                BigInt::BigInteger middleMultiplier = curPow.scalar_mult(middle);
-                if (middleMultiplier * rhs.abs() + currentSum <= this -> abs())
-                    lower_bound = middle;
-                else
-                    upper_bound = middle - 1;
-            }
-            resultVec.push_back(lower_bound);
-            currentSum += curPow.scalar_mult(lower_bound) * rhs.abs();
-            curPow = curPow.scale(-1);
-        }
-        std::reverse(resultVec.begin(), resultVec.end());
+BigInt::BigInteger BigInt::divexact(const BigInt::BigInteger &lhs, const BigInt::BigInteger &rhs) {
+    if (rhs.data.empty()) {
+        throw DivisionByZeroException();
     }
     BigInt::BigInteger result;
-    result.sign = (this->sign == rhs.sign ? BigIntegerSign::PLUS : BigIntegerSign::MINUS);
-    if (result.sign == BigIntegerSign::PLUS) {
-        result.data = resultVec;
-    } else {
-        result.data = resultVec;
-        if (result.abs() * rhs.abs() != this->abs())
-            result -= BigInteger(1);
+    size_t an = lhs.data.size(), bn = rhs.data.size();
+    if (an < bn) {
+        return result;
     }
+    result.data.resize(an - bn + 1);
+    mpn::divExact(result.data.data(), lhs.data.data(), an, rhs.data.data(), bn);
+    result.sign = lhs.sign == rhs.sign ? PLUS : MINUS;
     result.cleanup_zeroes();
     return result;
 }
 
+BigInt::BigInteger BigInt::BigInteger::operator/(const BigInt::BigInteger &rhs) const & {
+    BigInt::BigInteger result;
+    divide(*this, rhs, &result, nullptr);
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator/(const BigInt::BigInteger &rhs) && {
+    divide(*this, rhs, this, nullptr);
+    return std::move(*this);
+}
+
 BigInt::BigInteger BigInt::BigInteger::scale(int n) const {
-    BigInt::BigInteger result = *this;
+    BigInt::BigInteger result;
     if (n >= 0) {
-        std::vector<int> zeroes(n, 0);
-        result.data.reserve(result.data.size() + zeroes.size());
-        result.data.insert(result.data.begin(), zeroes.begin(), zeroes.end());
-    } else {
-        result.data = std::vector<int>(result.data.begin() - n, result.data.end());
+        result.data.resize(data.size() + n, 0);
+        std::copy(data.begin(), data.end(), result.data.begin() + n);
+    } else if (size_t(-n) < data.size()) {
+        result.data.assign(data.begin() - n, data.end());
     }
+    result.sign = sign;
+    result.cleanup_zeroes();
     return result;
 }
 
-BigInt::BigInteger BigInt::BigInteger::scalar_mult(int n) const {
+BigInt::BigInteger BigInt::BigInteger::scalar_mult(limb_t n) const {
     BigInt::BigInteger result = *this;
-    for (auto& x : result.data) {
-        x *= n;
-    }
+    mulAddLimb(result.data, n, 0);
+    result.cleanup_zeroes();
     return result;
 }
 
 BigInt::BigInteger &BigInt::BigInteger::operator+=(const BigInt::BigInteger &rhs) {
-    *this = *this + rhs;
+    add_signed(rhs.data.data(), rhs.data.size(), rhs.sign);
     return *this;
 }
 
 BigInt::BigInteger &BigInt::BigInteger::operator-=(const BigInt::BigInteger &rhs) {
-    *this = *this - rhs;
+    add_signed(rhs.data.data(), rhs.data.size(), rhs.sign == PLUS ? MINUS : PLUS);
     return *this;
 }
 
-BigInt::BigInteger BigInt::BigInteger::operator%(const BigInt::BigInteger &rhs) const {
+BigInt::BigInteger BigInt::BigInteger::operator%(const BigInt::BigInteger &rhs) const & {
     BigInt::BigInteger result;
-    return (*this) - rhs * (*this / rhs);
+    divide(*this, rhs, nullptr, &result);
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator%(const BigInt::BigInteger &rhs) && {
+    divide(*this, rhs, nullptr, this);
+    return std::move(*this);
 }
 
 BigInt::BigInteger &BigInt::BigInteger::operator/=(const BigInt::BigInteger &rhs) {
-    *this = *this / rhs;
+    divide(*this, rhs, this, nullptr);
     return *this;
 }
 
+BigInt::BigInteger BigInt::BigInteger::low_bits(size_t bits) const {
+    BigInt::BigInteger result;
+    size_t limbs = std::min(data.size(), (bits + LIMB_BITS - 1) / LIMB_BITS);
+    result.data.assign(data.begin(), data.begin() + limbs);
+    if (limbs * LIMB_BITS > bits) {
+        result.data.back() &= (limb_t(1) << (bits % LIMB_BITS)) - 1;
+    }
+    result.cleanup_zeroes();
+    return result;
+}
+
+void BigInt::BigInteger::sqrt_rem(const BigInt::BigInteger &n, BigInt::BigInteger &root,
+                                  BigInt::BigInteger &remainder) {
+    size_t length = n.bitLength();
+    if (length <= LIMB_BITS) {
+        limb_t value = n.data.empty() ? 0 : n.data[0];
+        limb_t s = static_cast<limb_t>(std::sqrt(static_cast<long double>(value)));
+        while (s > 0 && s > value / s) {
+            s--;
+        }
+        while (s + 1 <= value / (s + 1)) {
+            s++;
+        }
+        root = BigInteger(s);
+        remainder = BigInteger(value - s * s);
+        return;
+    }
+    // n = a3 * B^3 + a2 * B^2 + a1 * B + a0 with B = 2^half needs a3 >= B / 4,
+    // so odd lengths are first scaled by a power of four and the root scaled back
+    size_t half = (length + 3) / 4;
+    size_t scaleBits = (4 * half - length) / 2;
+    if (scaleBits > 0) {
+        sqrt_rem(n << (2 * scaleBits), root, remainder);
+        root >>= scaleBits;
+        remainder = n;
+        remainder.subMul(root, root);
+        return;
+    }
+    BigInt::BigInteger low = n.low_bits(half);
+    BigInt::BigInteger middle = (n >> half).low_bits(half);
+    sqrt_rem(n >> (2 * half), root, remainder);
+    // (q, u) = divmod(r' * B + a1, 2 s'), s = s' * B + q, r = u * B + a0 - q^2
+    remainder <<= half;
+    remainder += middle;
+    BigInt::BigInteger twiceRoot = root << 1;
+    std::pair<BigInteger, BigInteger> qu = divmod(remainder, twiceRoot);
+    root <<= half;
+    root += qu.first;
+    remainder = std::move(qu.second);
+    remainder <<= half;
+    remainder += low;
+    remainder.subMul(qu.first, qu.first);
+    // The quotient overshoots by at most one
+    if (remainder.signum() < 0) {
+        remainder += root;
+        --root;
+        remainder += root;
+    }
+}
+
 BigInt::BigInteger BigInt::BigInteger::sqrt() const {
-    BigInt::BigInteger result = getIntOfLen(this->data.size() / 2);
-    bool revert = false;
+    return sqrtRem().first;
+}
+
+std::pair<BigInt::BigInteger, BigInt::BigInteger> BigInt::BigInteger::sqrtRem() const {
+    if (sign == MINUS) {
+        throw InvalidRootException();
+    }
+    std::pair<BigInteger, BigInteger> result;
+    sqrt_rem(*this, result.first, result.second);
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::nthRoot(unsigned k) const {
+    if (k == 0 || (sign == MINUS && k % 2 == 0)) {
+        throw InvalidRootException();
+    }
+    if (sign == MINUS) {
+        return -abs().nthRoot(k);
+    }
+    if (k == 1 || data.empty()) {
+        return *this;
+    }
+    if (k == 2) {
+        return sqrt();
+    }
+    size_t length = bitLength();
+    if (length <= k) {
+        return BigInteger(1);
+    }
+    // Start from 53 significant bits of 2^(log2(this) / k)
+    size_t dropped = length > 53 ? length - 53 : 0;
+    double log2 = dropped + std::log2(static_cast<double>((*this >> dropped).toUint64()));
+    double rootLog2 = log2 / k;
+    BigInt::BigInteger x;
+    if (rootLog2 < 52) {
+        x = BigInteger(static_cast<limb_t>(std::exp2(rootLog2)) + 1);
+    } else {
+        size_t shift = static_cast<size_t>(rootLog2) - 52;
+        x = BigInteger(static_cast<limb_t>(std::exp2(rootLog2 - shift)) + 1) << shift;
+    }
+    // By AM-GM a Newton step from any positive guess lands on or above the root,
+    // after which the steps decrease until they reach it
+    auto step = [this, k](const BigInteger &x) {
+        BigInt::BigInteger next = *this / x.pow(BigInteger(k - 1));
+        next.addMul(x, BigInteger(k - 1));
+        next /= k;
+        return next;
+    };
+    x = step(x);
     while (true) {
-        BigInt::BigInteger nextResult = (*this / result + result) / BigInteger(2);
-        if (result == nextResult || (result < nextResult && revert)) {
-            break;
+        BigInt::BigInteger next = step(x);
+        if (next >= x) {
+            return x;
         }
-        revert = nextResult < result;
-        result = nextResult;
+        x = std::move(next);
     }
-    return result;
+}
+
+bool BigInt::BigInteger::isPerfectPower(BigInt::BigInteger *root, unsigned *exponent) const {
+    BigInt::BigInteger magnitude = abs();
+    if (magnitude <= 1) {
+        if (root != nullptr) {
+            *root = *this;
+        }
+        if (exponent != nullptr) {
+            *exponent = sign == MINUS ? 3 : 2;
+        }
+        return true;
+    }
+    // Only prime exponents need checking, and each must divide the power of two in the number
+    size_t length = magnitude.bitLength(), twos = magnitude.countTrailingZeros();
+    std::vector<bool> composite(length + 1);
+    for (size_t p = 2; p <= length; p++) {
+        if (composite[p]) {
+            continue;
+        }
+        for (size_t multiple = p * p; multiple <= length; multiple += p) {
+            composite[multiple] = true;
+        }
+        if ((sign == MINUS && p == 2) || twos % p != 0) {
+            continue;
+        }
+        BigInt::BigInteger candidate = nthRoot(p);
+        if (candidate.pow(BigInteger(p)) == *this) {
+            if (root != nullptr) {
+                *root = std::move(candidate);
+            }
+            if (exponent != nullptr) {
+                *exponent = p;
+            }
+            return true;
+        }
+    }
+    return false;
 }
 
 BigInt::BigInteger BigInt::BigInteger::restoreFromModuloes(const std::vector<BigInteger>& remainders,
@@ -386,103 +696,340 @@ BigInt::BigInteger BigInt::BigInteger::restoreFromModuloes(const std::vector<Big
 
     for (int i=0; i<primes.size(); i++)
         for (int j=0; j<primes.size(); j++)
-            reciprocals[i][j] = primes[i].pow(primes[j] - BigInteger(2), primes[j]);
+            reciprocals[i][j] = primes[i].pow(primes[j] - 2, primes[j]);
 
     BigInt::BigInteger curMultiplier(1);
     std::vector<BigInteger> answerVec(primes.size());
     for (int i=0; i<primes.size(); i++) {
         answerVec[i] = remainders[i];
+        // Fused in place, so no step builds a product temporary
         for (int j = 0; j < i; j++) {
-            answerVec[i] = reciprocals[j][i] * (answerVec[i] - answerVec[j]);
-            answerVec[i] %= primes[i];
+            (answerVec[i] -= answerVec[j]).mulMod(reciprocals[j][i], primes[i]);
         }
-        result += curMultiplier * answerVec[i];
+        result.addMul(curMultiplier, answerVec[i]);
         curMultiplier *= primes[i];
     }
     return result;
 }
 
 BigInt::BigInteger &BigInt::BigInteger::operator%=(const BigInt::BigInteger &rhs) {
-    return *this = *this % rhs;
+    divide(*this, rhs, nullptr, this);
+    return *this;
 }
 
 int BigInt::BigInteger::toInt() const {
-    int ans = 0;
-    if (this->data.empty()) return ans;
-    int curMultiplier = 1;
-    for (auto digit : this->data) {
-        ans += curMultiplier * digit;
-        curMultiplier *= MODULO;
+    std::int64_t ans = toInt64();
+    if (ans < std::numeric_limits<int>::min() || ans > std::numeric_limits<int>::max()) {
+        throw IntegerOverflowException();
     }
-    return ans;
+    return int(ans);
+}
+
+bool BigInt::BigInteger::fitsUint64() const {
+    return data.size() <= 1 && (data.empty() || sign == PLUS);
+}
+
+bool BigInt::BigInteger::fitsInt64() const {
+    if (data.size() > 1) {
+        return false;
+    }
+    limb_t limit = limb_t(std::numeric_limits<std::int64_t>::max()) + (sign == MINUS ? 1 : 0);
+    return data.empty() || data[0] <= limit;
+}
+
+std::int64_t BigInt::BigInteger::toInt64() const {
+    if (!fitsInt64()) {
+        throw IntegerOverflowException();
+    }
+    if (data.empty()) {
+        return 0;
+    }
+    // The magnitude of the minimum doesn't fit the positive range, so it is negated as unsigned
+    return sign == MINUS ? std::int64_t(limb_t(0) - data[0]) : std::int64_t(data[0]);
+}
+
+std::uint64_t BigInt::BigInteger::toUint64() const {
+    if (!fitsUint64()) {
+        throw IntegerOverflowException();
+    }
+    return data.empty() ? 0 : data[0];
+}
+
+void BigInt::BigInteger::add_word(limb_t magnitude, BigIntegerSign wordSign) {
+    if (magnitude != 0) {
+        add_signed(&magnitude, 1, wordSign);
+    }
+}
+
+void BigInt::BigInteger::mul_word(limb_t magnitude, BigIntegerSign wordSign) {
+    if (magnitude == 0 || data.empty()) {
+        data.clear();
+        sign = PLUS;
+        return;
+    }
+    limb_t carry = mpn::mul1(data.data(), data.data(), data.size(), magnitude);
+    if (carry != 0) {
+        data.push_back(carry);
+    }
+    if (wordSign == MINUS) {
+        inverse_sign();
+    }
+}
+
+BigInt::limb_t BigInt::BigInteger::divmod_word(limb_t magnitude, BigIntegerSign wordSign) {
+    if (magnitude == 0) {
+        throw DivisionByZeroException();
+    }
+    limb_t remainder = mpn::divRem1(data.data(), data.data(), data.size(), magnitude);
+    sign = sign == wordSign ? PLUS : MINUS;
+    // Quotients are rounded towards minus infinity
+    if (sign == MINUS && remainder != 0) {
+        limb_t one = 1;
+        data.push_back(0);
+        mpn::add(data.data(), data.data(), data.size(), &one, 1);
+        remainder = magnitude - remainder;
+    }
+    cleanup_zeroes();
+    return remainder;
+}
+
+int BigInt::BigInteger::compare_word(limb_t magnitude, BigIntegerSign wordSign) const {
+    if (magnitude == 0) {
+        return signum();
+    }
+    if (data.empty()) {
+        return wordSign == MINUS ? 1 : -1;
+    }
+    if (sign != wordSign) {
+        return sign == MINUS ? -1 : 1;
+    }
+    int cmp = data.size() > 1 ? 1 : (data[0] < magnitude ? -1 : data[0] > magnitude);
+    return sign == PLUS ? cmp : -cmp;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::operator++() {
+    limb_t one = 1;
+    add_signed(&one, 1, PLUS);
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::operator--() {
+    limb_t one = 1;
+    add_signed(&one, 1, MINUS);
+    return *this;
 }
 
 const BigInt::BigInteger BigInt::BigInteger::operator++(int) {
-    return *this = *this + BigInteger(1);
+    BigInt::BigInteger old = *this;
+    ++*this;
+    return old;
+}
+
+const BigInt::BigInteger BigInt::BigInteger::operator--(int) {
+    BigInt::BigInteger old = *this;
+    --*this;
+    return old;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator<<(size_t shift) const {
+    BigInt::BigInteger result(*this);
+    result <<= shift;
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator>>(size_t shift) const {
+    BigInt::BigInteger result(*this);
+    result >>= shift;
+    return result;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::operator<<=(size_t shift) {
+    if (data.empty()) {
+        return *this;
+    }
+    size_t limbs = shift / LIMB_BITS, n = data.size();
+    unsigned bits = shift % LIMB_BITS;
+    data.resize(n + limbs + 1);
+    limb_t *d = data.data();
+    d[n + limbs] = mpn::lshift(d + limbs, d, n, bits);
+    std::fill(d, d + limbs, 0);
+    cleanup_zeroes();
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::operator>>=(size_t shift) {
+    if (data.empty()) {
+        return *this;
+    }
+    size_t limbs = shift / LIMB_BITS, n = data.size();
+    unsigned bits = shift % LIMB_BITS;
+    bool negative = sign == MINUS;
+    bool inexact;
+    if (limbs >= n) {
+        data.clear();
+        inexact = true;
+    } else {
+        limb_t *d = data.data();
+        inexact = std::any_of(d, d + limbs, [](limb_t x) { return x != 0; });
+        inexact |= mpn::rshift(d, d + limbs, n - limbs, bits) != 0;
+        data.resize(n - limbs);
+    }
+    cleanup_zeroes();
+    // Rounding the magnitude up rounds a negative value down
+    if (negative && inexact) {
+        add_word(1, MINUS);
+    }
+    return *this;
+}
+
+template<class Op>
+void BigInt::BigInteger::bitwise(const BigInteger &rhs, Op op) {
+    // One limb above the longer magnitude holds the sign of both operands
+    size_t n = std::max(data.size(), rhs.data.size()) + 1;
+    bool resultNegative = op(sign == MINUS ? ~limb_t(0) : 0, rhs.sign == MINUS ? ~limb_t(0) : 0) != 0;
+    // Two's complement of a negative magnitude is ~(x - 1), so a borrow runs through the low zero limbs
+    bool lhsBorrow = sign == MINUS, rhsBorrow = rhs.sign == MINUS, resultCarry = resultNegative;
+    data.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        limb_t a = data[i];
+        if (sign == MINUS) {
+            limb_t decremented = a - lhsBorrow;
+            lhsBorrow = lhsBorrow && a == 0;
+            a = ~decremented;
+        }
+        limb_t b = i < rhs.data.size() ? rhs.data[i] : 0;
+        if (rhs.sign == MINUS) {
+            limb_t decremented = b - rhsBorrow;
+            rhsBorrow = rhsBorrow && b == 0;
+            b = ~decremented;
+        }
+        limb_t r = op(a, b);
+        // A negative result is converted back to its magnitude ~r + 1
+        if (resultNegative) {
+            r = ~r + resultCarry;
+            resultCarry = resultCarry && r == 0;
+        }
+        data[i] = r;
+    }
+    sign = resultNegative ? MINUS : PLUS;
+    cleanup_zeroes();
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator~() const {
+    BigInt::BigInteger result = -*this;
+    --result;
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator&(const BigInt::BigInteger &rhs) const {
+    BigInt::BigInteger result(*this);
+    result &= rhs;
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator|(const BigInt::BigInteger &rhs) const {
+    BigInt::BigInteger result(*this);
+    result |= rhs;
+    return result;
+}
+
+BigInt::BigInteger BigInt::BigInteger::operator^(const BigInt::BigInteger &rhs) const {
+    BigInt::BigInteger result(*this);
+    result ^= rhs;
+    return result;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::operator&=(const BigInt::BigInteger &rhs) {
+    bitwise(rhs, [](limb_t a, limb_t b) { return a & b; });
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::operator|=(const BigInt::BigInteger &rhs) {
+    bitwise(rhs, [](limb_t a, limb_t b) { return a | b; });
+    return *this;
+}
+
+BigInt::BigInteger &BigInt::BigInteger::operator^=(const BigInt::BigInteger &rhs) {
+    bitwise(rhs, [](limb_t a, limb_t b) { return a ^ b; });
+    return *this;
+}
+
+size_t BigInt::BigInteger::bitLength() const {
+    if (data.empty()) {
+        return 0;
+    }
+    return LIMB_BITS * data.size() - __builtin_clzll(data.back());
+}
+
+bool BigInt::BigInteger::testBit(size_t bit) const {
+    size_t limb = bit / LIMB_BITS;
+    bool magnitudeBit = limb < data.size() && (data[limb] >> (bit % LIMB_BITS) & 1);
+    if (sign == PLUS) {
+        return magnitudeBit;
+    }
+    // Below the lowest set bit ~(x - 1) is 0, at it 1, and above it the inverted magnitude
+    size_t lowest = countTrailingZeros();
+    return bit < lowest ? false : bit == lowest || !magnitudeBit;
+}
+
+size_t BigInt::BigInteger::countTrailingZeros() const {
+    for (size_t i = 0; i < data.size(); i++) {
+        if (data[i] != 0) {
+            return i * LIMB_BITS + __builtin_ctzll(data[i]);
+        }
+    }
+    return 0;
+}
+
+size_t BigInt::BigInteger::popcount() const {
+    size_t count = 0;
+    for (limb_t x : data) {
+        count += __builtin_popcountll(x);
+    }
+    return count;
 }
 
 bool BigInt::BigInteger::isOdd() const {
     if (data.empty()) return false;
-    return data[0] % 2;
+    return data[0] & 1;
 }
 
 BigInt::BigInteger BigInt::BigInteger::getRandOfLen(int len) {
-    BigInteger ans = getIntOfLen(len);
-    std::uniform_int_distribution<int> distribution(0, MODULO - 1);
-    static std::random_device randomDevice;
-    for (int i = 0; i < len; i++) {
-        ans.data[i] = distribution(randomDevice);
+    if (len <= 0) {
+        return BigInteger();
     }
-    return ans;
+    static const BigInteger CELL_MODULO(1000000);
+    return RandomSource::current().below(CELL_MODULO.pow(BigInteger(len)));
 }
 
 BigInt::BigInteger BigInt::BigInteger::getRandOfBitLen(int len) {
-    BigInteger ans(0);
-    std::uniform_int_distribution<int> distribution(0, 1);
-    static std::random_device randomDevice;
-    BigInteger currentPower(1);
-    for (int i = 0; i < len; i++) {
-        if (distribution(randomDevice)) {
-            ans += currentPower;
-        }
-        currentPower *= BigInteger(2);
-    }
-    return ans;
+    return len > 0 ? RandomSource::current().randomBits(len) : BigInteger();
 }
 
 BigInt::BigInteger BigInt::BigInteger::rand(const BigInt::BigInteger &maxVal) {
-    BigInteger ans = getRandOfLen(maxVal.data.size());
-    return ans % maxVal;
+    if (maxVal.data.empty()) {
+        throw DivisionByZeroException();
+    }
+    // Negative bounds give values in (maxVal, 0], as the remainder by them used to
+    BigInteger ans = RandomSource::current().below(maxVal.abs());
+    if (maxVal.sign == MINUS) {
+        ans.inverse_sign();
+        ans.cleanup_zeroes();
+    }
+    return ans;
 }
 
 std::string BigInt::BigInteger::toString() const {
-    std::stringstream ss;
-    ss << *this;
-    return ss.str();
-}
-
-void BigInt::fft(std::vector<BigInt::fft_base> &arg, bool invert) {
-    int n = arg.size();
-    if (n == 1) {
-        return;
+    size_t width = detail::decimalWidth(data.data(), data.size());
+    std::string result(width + 1, '-');
+    detail::toDecimal(&result[1], width, data.data(), data.size());
+    // Leading zeros of the padded width are dropped, keeping the last digit of zero
+    size_t first = result.find_first_not_of('0', 1);
+    if (first == std::string::npos) {
+        first = width;
     }
-    std::vector<BigInt::fft_base> a0(n / 2), a1(n / 2);
-    for (int i = 0, j = 0; i < n; i += 2, j++) {
-        a0[j] = arg[i];
-        a1[j] = arg[i+1];
-    }
-    BigInt::fft(a0, invert);
-    BigInt::fft(a1, invert);
-
-    double angle = 2 * M_PI / n * (invert ? -1 : 1);
-    BigInt::fft_base w(1), wn(cos(angle), sin(angle));
-    for (int i = 0; i < n / 2; i++) {
-        arg[i] = a0[i] + w * a1[i];
-        arg[i + n / 2] = a0[i] -  w * a1[i];
-        if (invert) {
-            arg[i] /= 2;
-            arg[i + n / 2] /= 2;
-        }
-        w *= wn;
+    if (sign == MINUS) {
+        result[--first] = '-';
     }
-}
\ No newline at end of file
+    return result.substr(first);
+}
@@ -4,6 +4,11 @@
 #include <vector>
 #include <iostream>
 #include <complex>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+#include "BigIntegerLimbBuffer.h"
 
 namespace BigInt {
 
@@ -16,11 +21,68 @@ namespace BigInt {
 
     void fft(std::vector<fft_base> &arg, bool invert = false);
 
+    // Operand lengths (in limbs of the shorter factor) from which
+    // operator* switches to the next multiplication algorithm.
+    struct MultiplicationThresholds {
+        size_t karatsuba;
+        size_t toom3;
+        size_t fft;
+    };
+
+    MultiplicationThresholds getMultiplicationThresholds();
+    void setMultiplicationThresholds(const MultiplicationThresholds &thresholds);
+
+    // Threads, the calling one included, that a single product of Toom-3 size or more is split over.
+    // 0 means one per hardware thread, which is the default; 1 keeps every product serial.
+    // Must not be changed while another thread is multiplying.
+    void setMultiplicationThreads(unsigned threads);
+    unsigned getMultiplicationThreads();
+
+    class BigInteger;
+    class MontgomeryContext;
+    class RandomSource;
+    template<size_t Bits>
+    class FixedBigInteger;
+
+    // Lazy expressions, see BigIntegerExpression.h
+    namespace expr {
+        template<class T>
+        struct IsExpression : std::false_type {};
+
+        template<class E>
+        void assign(BigInteger &dst, const E &e);
+    }
+
     struct InvalidBigIntegerStringException : public std::exception {
         const char *what() const noexcept override {
             return "Invalid string value for BigInteger cast";
         }
     };
+    struct DivisionByZeroException : public std::exception {
+        const char *what() const noexcept override {
+            return "Division by zero";
+        }
+    };
+    struct IntegerOverflowException : public std::exception {
+        const char *what() const noexcept override {
+            return "Value does not fit the requested integer type";
+        }
+    };
+    struct InvalidRootException : public std::exception {
+        const char *what() const noexcept override {
+            return "Root of degree zero or even root of a negative number";
+        }
+    };
+    struct InvalidModulusException : public std::exception {
+        const char *what() const noexcept override {
+            return "Montgomery arithmetic needs an odd modulus above one";
+        }
+    };
+    struct NotInvertibleException : public std::exception {
+        const char *what() const noexcept override {
+            return "Number has no inverse modulo the given modulus";
+        }
+    };
     struct InvalidConsoleArguments : public std::exception {
         const char* what () const noexcept override {
             return "Invalid arguments. See \'help\' command for reference";
@@ -29,31 +91,109 @@ namespace BigInt {
 
     class BigInteger {
     protected:
-        static const int CELL_LENGTH = 6;
-        static const int MODULO = 1000000;
+        // Magnitude is kept in base 2^64, least significant limb first.
+        // Decimal digits only appear when parsing from and printing to strings.
+        static const int LIMB_BITS = 64;
 
         BigIntegerSign sign;
-        std::vector<int> data;
+        LimbBuffer data;
 
         void inverse_sign();
         void cleanup_zeroes();
+        // Adds the magnitude b[0, bn) taken with sign bSign to this number in place
+        void add_signed(const limb_t *b, size_t bn, BigIntegerSign bSign);
+        // Floor division writing into the given results, either of which may be null or alias an operand
+        static void divide(const BigInteger &lhs, const BigInteger &rhs, BigInteger *quotient, BigInteger *remainder);
+        static void divide(const limb_t *a, size_t an, BigIntegerSign aSign, const BigInteger &rhs,
+                           BigInteger *quotient, BigInteger *remainder);
+        // Single-word counterparts of the generic paths, for operands given as magnitude and sign
+        void add_word(limb_t magnitude, BigIntegerSign wordSign);
+        void mul_word(limb_t magnitude, BigIntegerSign wordSign);
+        // Floor-divides in place and returns the magnitude of the remainder, which has the sign of the divisor
+        limb_t divmod_word(limb_t magnitude, BigIntegerSign wordSign);
+        int compare_word(limb_t magnitude, BigIntegerSign wordSign) const;
+        // Applies op limb by limb to the two's complement forms of both numbers
+        template<class Op>
+        void bitwise(const BigInteger &rhs, Op op);
+
+        template<class T>
+        using EnableIfWord = typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                                     sizeof(T) <= sizeof(limb_t), int>::type;
+
+        template<class T>
+        static limb_t wordMagnitude(T x) {
+            return std::is_signed<T>::value && x < 0 ? limb_t(0) - limb_t(x) : limb_t(x);
+        }
+
+        template<class T>
+        static BigIntegerSign wordSign(T x) {
+            return std::is_signed<T>::value && x < 0 ? MINUS : PLUS;
+        }
+
+        // The lowest bits of the magnitude, taken as a non-negative number
+        BigInteger low_bits(size_t bits) const;
+        // Karatsuba square root of a non-negative n
+        static void sqrt_rem(const BigInteger &n, BigInteger &root, BigInteger &remainder);
+        // Reduces a sum or difference of residues modulo modulo, by one correction where that is enough
+        void reduce_once(const BigInteger &modulo);
         BigInteger scale(int n) const;
-        BigInteger scalar_mult(int n) const;
+        BigInteger scalar_mult(limb_t n) const;
         static BigInteger getIntOfLen(int len);
         friend std::ostream &operator<<(std::ostream &os, const BigInteger &rhs);
         friend std::istream &operator>>(std::istream &is, BigInteger &rhs);
+        friend std::pair<BigInteger, BigInteger> divmod(const BigInteger &lhs, const BigInteger &rhs);
+        friend BigInteger divexact(const BigInteger &lhs, const BigInteger &rhs);
+        friend class MontgomeryContext;
+        friend class RandomSource;
+        template<size_t Bits>
+        friend class FixedBigInteger;
 
     public:
-        explicit BigInteger(int x);
+        // Any built-in integer up to 64 bits, signed or not
+        template<class T, EnableIfWord<T> = 0>
+        explicit BigInteger(T x) : BigInteger() {
+            add_word(wordMagnitude(x), wordSign(x));
+        }
+
         explicit BigInteger(const std::string &s);
+        // Checked conversions, throwing IntegerOverflowException when the value doesn't fit
         int toInt() const;
+        bool fitsInt64() const;
+        bool fitsUint64() const;
+        std::int64_t toInt64() const;
+        std::uint64_t toUint64() const;
         std::string toString() const;
         bool isOdd() const;
         BigInteger(const BigInteger &) = default;
+        BigInteger(BigInteger &&) noexcept = default;
         BigInteger();
+        BigInteger &operator=(const BigInteger &) = default;
+        BigInteger &operator=(BigInteger &&) noexcept = default;
+
+        // Evaluate a whole lazy expression at once
+        template<class E, class = typename std::enable_if<expr::IsExpression<E>::value>::type>
+        BigInteger(const E &e) : BigInteger() {
+            expr::assign(*this, e);
+        }
+
+        template<class E, class = typename std::enable_if<expr::IsExpression<E>::value>::type>
+        BigInteger &operator=(const E &e) {
+            expr::assign(*this, e);
+            return *this;
+        }
+
         BigInteger abs() const;
+        // Uniform in [0, maxVal), drawn from the RandomSource of the calling thread
         static BigInteger rand(const BigInteger& maxVal);
 
+        // -1, 0 or 1 as this is below, equal to or above rhs, in one pass over the limbs
+        int compare(const BigInteger &rhs) const;
+        int compareAbs(const BigInteger &rhs) const;
+        bool isZero() const;
+        bool isOne() const;
+        // -1, 0 or 1 by the sign of the value
+        int signum() const;
+
         bool operator==(const BigInteger &rhs) const;
         bool operator!=(const BigInteger &rhs) const;
         bool operator<(const BigInteger &rhs) const;
@@ -61,32 +201,227 @@ namespace BigInt {
         bool operator>(const BigInteger &rhs) const;
         bool operator>=(const BigInteger &rhs) const;
 
+        template<class T, EnableIfWord<T> = 0>
+        int compare(T rhs) const { return compare_word(wordMagnitude(rhs), wordSign(rhs)); }
+        template<class T, EnableIfWord<T> = 0>
+        bool operator==(T rhs) const { return compare(rhs) == 0; }
+        template<class T, EnableIfWord<T> = 0>
+        bool operator!=(T rhs) const { return compare(rhs) != 0; }
+        template<class T, EnableIfWord<T> = 0>
+        bool operator<(T rhs) const { return compare(rhs) < 0; }
+        template<class T, EnableIfWord<T> = 0>
+        bool operator<=(T rhs) const { return compare(rhs) <= 0; }
+        template<class T, EnableIfWord<T> = 0>
+        bool operator>(T rhs) const { return compare(rhs) > 0; }
+        template<class T, EnableIfWord<T> = 0>
+        bool operator>=(T rhs) const { return compare(rhs) >= 0; }
+
         BigInteger operator+() const;
         BigInteger operator-() const;
-        BigInteger operator+(const BigInteger &rhs) const;
-        BigInteger operator-(const BigInteger &rhs) const;
-        BigInteger operator*(const BigInteger &rhs) const;
-        BigInteger operator/(const BigInteger &rhs) const;
-        BigInteger operator%(const BigInteger &rhs) const;
+        // Overloads taking an rvalue operand compute the result in its storage
+        BigInteger operator+(const BigInteger &rhs) const &;
+        BigInteger operator+(const BigInteger &rhs) &&;
+        BigInteger operator+(BigInteger &&rhs) const &;
+        BigInteger operator+(BigInteger &&rhs) &&;
+        BigInteger operator-(const BigInteger &rhs) const &;
+        BigInteger operator-(const BigInteger &rhs) &&;
+        BigInteger operator-(BigInteger &&rhs) const &;
+        BigInteger operator-(BigInteger &&rhs) &&;
+        BigInteger operator*(const BigInteger &rhs) const &;
+        BigInteger operator*(const BigInteger &rhs) &&;
+        BigInteger operator*(BigInteger &&rhs) const &;
+        BigInteger operator*(BigInteger &&rhs) &&;
+        BigInteger operator/(const BigInteger &rhs) const &;
+        BigInteger operator/(const BigInteger &rhs) &&;
+        BigInteger operator%(const BigInteger &rhs) const &;
+        BigInteger operator%(const BigInteger &rhs) &&;
         BigInteger &operator*=(const BigInteger &rhs);
         BigInteger &operator+=(const BigInteger &rhs);
         BigInteger &operator-=(const BigInteger &rhs);
         BigInteger &operator/=(const BigInteger &rhs);
         BigInteger &operator%=(const BigInteger &rhs);
+
+        // Arithmetic with a built-in integer runs in one pass over the limbs
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger &operator+=(T rhs) {
+            add_word(wordMagnitude(rhs), wordSign(rhs));
+            return *this;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger &operator-=(T rhs) {
+            add_word(wordMagnitude(rhs), wordSign(rhs) == PLUS ? MINUS : PLUS);
+            return *this;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger &operator*=(T rhs) {
+            mul_word(wordMagnitude(rhs), wordSign(rhs));
+            return *this;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger &operator/=(T rhs) {
+            divmod_word(wordMagnitude(rhs), wordSign(rhs));
+            return *this;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger &operator%=(T rhs) {
+            BigIntegerSign remainderSign = wordSign(rhs);
+            limb_t remainder = divmod_word(wordMagnitude(rhs), remainderSign);
+            data.clear();
+            sign = PLUS;
+            add_word(remainder, remainderSign);
+            return *this;
+        }
+
+        // Floor-divides this number by rhs in place and returns the remainder, which has the sign of rhs
+        template<class T, EnableIfWord<T> = 0>
+        T divideInPlace(T rhs) {
+            limb_t remainder = divmod_word(wordMagnitude(rhs), wordSign(rhs));
+            return wordSign(rhs) == MINUS ? -static_cast<T>(remainder) : static_cast<T>(remainder);
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator+(T rhs) const & {
+            BigInteger result(*this);
+            result += rhs;
+            return result;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator+(T rhs) && {
+            *this += rhs;
+            return std::move(*this);
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator-(T rhs) const & {
+            BigInteger result(*this);
+            result -= rhs;
+            return result;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator-(T rhs) && {
+            *this -= rhs;
+            return std::move(*this);
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator*(T rhs) const & {
+            BigInteger result(*this);
+            result *= rhs;
+            return result;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator*(T rhs) && {
+            *this *= rhs;
+            return std::move(*this);
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator/(T rhs) const & {
+            BigInteger result(*this);
+            result /= rhs;
+            return result;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator/(T rhs) && {
+            *this /= rhs;
+            return std::move(*this);
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator%(T rhs) const & {
+            BigInteger result(*this);
+            result %= rhs;
+            return result;
+        }
+
+        template<class T, EnableIfWord<T> = 0>
+        BigInteger operator%(T rhs) && {
+            *this %= rhs;
+            return std::move(*this);
+        }
+
+        // Fused forms that keep the product in scratch instead of a temporary:
+        // *this += a * b, *this -= a * b and *this = *this * rhs % modulo
+        BigInteger &addMul(const BigInteger &a, const BigInteger &b);
+        BigInteger &subMul(const BigInteger &a, const BigInteger &b);
+        BigInteger &mulMod(const BigInteger &rhs, const BigInteger &modulo);
+        // *this = (*this + rhs) % modulo and (*this - rhs) % modulo, without a division when both lie in [0, modulo)
+        BigInteger &addMod(const BigInteger &rhs, const BigInteger &modulo);
+        BigInteger &subMod(const BigInteger &rhs, const BigInteger &modulo);
+        BigInteger &operator++();
+        BigInteger &operator--();
         const BigInteger operator++(int);
+        const BigInteger operator--(int);
+
+        // Shifts by whole bits; >> rounds towards minus infinity, like division by a power of two
+        BigInteger operator<<(size_t shift) const;
+        BigInteger operator>>(size_t shift) const;
+        BigInteger &operator<<=(size_t shift);
+        BigInteger &operator>>=(size_t shift);
+        // Bitwise operations act on the infinite two's complement representation
+        BigInteger operator~() const;
+        BigInteger operator&(const BigInteger &rhs) const;
+        BigInteger operator|(const BigInteger &rhs) const;
+        BigInteger operator^(const BigInteger &rhs) const;
+        BigInteger &operator&=(const BigInteger &rhs);
+        BigInteger &operator|=(const BigInteger &rhs);
+        BigInteger &operator^=(const BigInteger &rhs);
 
+        // Number of bits in the magnitude, 0 for zero
+        size_t bitLength() const;
+        // Bit of the two's complement representation, so negative numbers have all high bits set
+        bool testBit(size_t bit) const;
+        // Index of the lowest set bit, 0 for zero
+        size_t countTrailingZeros() const;
+        // Set bits of the magnitude
+        size_t popcount() const;
+
+        // Exponents below one give 1; a zero modulo means the power is not reduced
         BigInteger pow(BigInteger exp, const BigInteger &modulo = BigInteger(0)) const;
+        // Floor square root and the remainder this - root^2, throwing InvalidRootException for negative numbers
         BigInteger sqrt() const;
+        std::pair<BigInteger, BigInteger> sqrtRem() const;
+        // k-th root rounded towards zero; odd roots of negative numbers are negative
+        BigInteger nthRoot(unsigned k) const;
+        // Whether this is root^exponent for some exponent >= 2, optionally reporting the smallest such exponent.
+        // 0, 1 and -1 count as perfect powers of themselves.
+        bool isPerfectPower(BigInteger *root = nullptr, unsigned *exponent = nullptr) const;
+        BigInteger square() const;
 
         static BigInteger
             restoreFromModuloes(const std::vector<BigInteger> &remainders, const std::vector<BigInteger> &primes);
 
+        // Uniform in [0, 10^(6 len)): len counts the six-digit decimal cells numbers used to be stored in,
+        // not limbs, so callers get the same widths as before. getRandOfBitLen is uniform in [0, 2^len).
         static BigInteger getRandOfLen(int len);
         static BigInteger getRandOfBitLen(int len);
     };
 
     std::ostream &operator<<(std::ostream &os, const BigInteger &rhs);
     std::istream &operator>>(std::istream &is, BigInteger &rhs);
+
+    // Quotient rounded towards minus infinity and the matching remainder, which has the sign of rhs,
+    // computed by a single division
+    std::pair<BigInteger, BigInteger> divmod(const BigInteger &lhs, const BigInteger &rhs);
+
+    // lhs / rhs for an rhs known to divide lhs, much cheaper than operator/.
+    // The result is unspecified if the division is not exact.
+    BigInteger divexact(const BigInteger &lhs, const BigInteger &rhs);
+
+    template<class T, class = typename std::enable_if<std::is_integral<T>::value>::type>
+    std::pair<BigInteger, T> divmod(const BigInteger &lhs, T rhs) {
+        BigInteger quotient(lhs);
+        T remainder = quotient.divideInPlace(rhs);
+        return std::make_pair(std::move(quotient), remainder);
+    }
 }
 
 #endif //BIG_INTEGER_BIG_INTEGER_H
\ No newline at end of file
@@ -3,6 +3,8 @@
 //
 
 #include "BigIntegerAlgorithm.h"
+#include "BigIntegerExpression.h"
+#include "BigIntegerMontgomery.h"
 #include <map>
 #include <algorithm>
 #include <set>
@@ -17,19 +19,32 @@ std::vector<BigInt::BigInteger> BigInt::factorize(const BigInt::BigInteger& arg)
         ans.emplace_back(arg);
         return ans;
     }
-    if (arg <= BigInteger(10000000)) {
+    if (arg <= 10000000) {
         return smallFactorize(arg);
     }
+    // Pollard's walk only finds a repeated prime slowly, so powers are split up front
+    BigInteger root;
+    unsigned exponent;
+    if (arg.isPerfectPower(&root, &exponent)) {
+        std::vector<BigInt::BigInteger> factors = factorize(root);
+        for (unsigned i = 0; i < exponent; i++) {
+            ans.insert(ans.end(), factors.begin(), factors.end());
+        }
+        std::sort(ans.begin(), ans.end());
+        return ans;
+    }
+    const BigInteger one(1);
     for (const auto& x : smallPrimes) {
         std::vector<BigInt::BigInteger> allNumbers;
         allNumbers.emplace_back(x);
         for (int i=1; i<NUMBER_OF_STEPS; i++) {
-            allNumbers.emplace_back((allNumbers[i-1] * allNumbers[i-1] + BigInteger(1)) % arg);
+            BigInteger next = (lazy(allNumbers[i-1]) * allNumbers[i-1] + one) % arg;
+            allNumbers.push_back(std::move(next));
             BigInt::BigInteger d = BigInt::gcd(arg, (allNumbers[i]-allNumbers[i/2]).abs());
-            if (d != BigInteger(1)) {
+            if (!d.isOne()) {
                 std::vector<BigInt::BigInteger> factors = factorize(d);
                 ans.insert(ans.end(), factors.begin(), factors.end());
-                std::vector<BigInt::BigInteger> additionalFactors = factorize(arg / d);
+                std::vector<BigInt::BigInteger> additionalFactors = factorize(divexact(arg, d));
                 ans.insert(ans.end(), additionalFactors.begin(), additionalFactors.end());
                 std::sort(ans.begin(), ans.end());
                 return ans;
@@ -54,28 +69,32 @@ std::vector<BigInt::BigInteger> BigInt::smallFactorize(const BigInt::BigInteger&
 }
 
 bool BigInt::isPrime(const BigInt::BigInteger& arg) {
-    if (arg < BigInteger(1000000)) {
+    if (arg < 1000000) {
         return smallIsPrime(arg);
     }
-    BigInteger curPower(1), curExp(0);
-    while ((arg - BigInteger(1)) % (curPower * BigInteger(2)) == BigInteger(0)) {
-        curPower *= BigInteger(2);
-        curExp++;
+    if (!arg.isOdd()) {
+        return false;
     }
-    BigInteger rem((arg - BigInteger(1)) / curPower);
-
+    const BigInteger argMinusOne = arg - 1;
+    // arg - 1 = rem * 2^curExp with rem odd
+    size_t curExp = argMinusOne.countTrailingZeros();
+    BigInteger rem = argMinusOne >> curExp;
+
+    // All the witnesses are raised and squared in Montgomery form, where 1 and -1 have their own images
+    const MontgomeryContext field(arg);
+    const BigInteger minusOne = field.toMontgomery(argMinusOne);
     for (const auto& x : smallPrimes) {
-        if (x.pow(rem, arg) == BigInteger(1)) {
+        BigInteger curTrial = field.pow(field.toMontgomery(x), rem);
+        if (curTrial == field.one()) {
             continue;
         }
         bool isEvidence = false;
-        BigInteger curTrial = x.pow(rem, arg);
-        for (BigInteger i(0); i < curExp; i++) {
-            if (curTrial == arg - BigInteger(1)) {
+        for (size_t i = 0; i < curExp; i++) {
+            if (curTrial == minusOne) {
                 isEvidence = true;
                 break;
             }
-            curTrial = (curTrial * curTrial) % arg;
+            curTrial = field.square(curTrial);
         }
         if (!isEvidence) {
             return false;
@@ -95,28 +114,31 @@ bool BigInt::smallIsPrime(const BigInt::BigInteger& arg) {
 }
 
 BigInt::BigInteger BigInt::gcd(const BigInt::BigInteger& a, const BigInt::BigInteger& b) {
-    if (a == BigInteger(0) || b == BigInteger(0)) {
+    if (a.isZero() || b.isZero()) {
         return a + b;
     }
     return gcd(b, a % b);
 }
 
 BigInt::BigInteger BigInt::log(const BigInteger& arg, const BigInteger& base, const BigInteger& modulo) {
-    BigInteger m = modulo.sqrt() + BigInteger(1);
+    BigInteger m = modulo.sqrt() + 1;
     BigInteger multiplier = base.pow(m, modulo);
     BigInteger curPow = multiplier;
     std::map<BigInteger, BigInteger> table;
-    for (BigInteger i(1); i <= m; i++) {
+    for (BigInteger i(1); i <= m; ++i) {
         if (table.find(curPow) == table.end())
             table[curPow] = i;
-        curPow = (curPow * multiplier) % modulo;
+        curPow *= multiplier;
+        curPow %= modulo;
     }
     BigInteger curCheck = arg;
-    for (BigInteger j(0); j < m; j++) {
-        if (table.find(curCheck) != table.end()) {
-            return table[curCheck] * m - j;
+    for (BigInteger j(0); j < m; ++j) {
+        auto it = table.find(curCheck);
+        if (it != table.end()) {
+            return it->second * m - j;
         }
-        curCheck = (curCheck * base) % modulo;
+        curCheck *= base;
+        curCheck %= modulo;
     }
     return BigInteger(0);
 }
@@ -126,7 +148,7 @@ BigInt::BigInteger BigInt::eulerFunc(const BigInt::BigInteger &arg) {
     std::set<BigInt::BigInteger> uniqueFactors(factors.begin(), factors.end());
     BigInteger ans = arg;
     for (const auto& factor : uniqueFactors) {
-        ans -= ans / factor;
+        ans -= divexact(ans, factor);
     }
     return ans;
 }
@@ -145,11 +167,11 @@ BigInt::BigInteger BigInt::mobiusFunc(const BigInt::BigInteger &arg) {
 
 BigInt::BigInteger BigInt::legendreSymbol(const BigInt::BigInteger &a, const BigInt::BigInteger &p) {
     BigInteger cp = a;
-    while (cp < BigInteger(0)) {
+    while (cp.signum() < 0) {
         cp = a + p;
     }
-    BigInteger ans = cp.pow((p - BigInteger(1)) / BigInteger(2), p);
-    if (ans == p - BigInteger(1)) {
+    BigInteger ans = cp.pow((p - 1) / 2, p);
+    if (ans == p - 1) {
         return BigInteger(-1);
     } else {
         return ans;
@@ -161,7 +183,7 @@ BigInt::BigInteger BigInt::jacobiSymbol(const BigInt::BigInteger &a, const BigIn
     BigInteger ans(1);
     for (const auto& factor : factors) {
         ans *= legendreSymbol(a, factor);
-        if (ans == BigInteger(0)) {
+        if (ans.isZero()) {
             break;
         }
     }
@@ -169,53 +191,68 @@ BigInt::BigInteger BigInt::jacobiSymbol(const BigInt::BigInteger &a, const BigIn
 }
 
 BigInt::BigInteger BigInt::sqrtMod(const BigInt::BigInteger &arg, const BigInt::BigInteger &modulo) {
-    if (BigInt::legendreSymbol(arg, modulo) != BigInteger(1)) {
+    // Cipolla's method needs an odd prime modulus; the search for a non-residue below never ends for 2
+    if (!modulo.isOdd()) {
+        return BigInteger(-1);
+    }
+    if (!BigInt::legendreSymbol(arg, modulo).isOne()) {
         return BigInteger(-1);
     }
 
     BigInteger a(0);
     while (true) {
-        if (BigInt::legendreSymbol(a * a - arg, modulo) == BigInteger(-1)) {
+        if (BigInt::legendreSymbol(a.square() - arg, modulo) == BigInteger(-1)) {
               break;
         } else {
-            a++;
+            ++a;
         }
     }
-    auto multiplyPair = [omega = a * a - arg, p = modulo](const std::pair<BigInteger, BigInteger>& lhs,
-                                                          const std::pair<BigInteger, BigInteger>& rhs) {
-        return std::make_pair((lhs.first * rhs.first + lhs.second * rhs.second * omega) % p,
-                              (lhs.first * rhs.second + lhs.second * rhs.first) % p);
+    // The pairs are kept in Montgomery form
+    const MontgomeryContext field(modulo);
+    auto addPair = [&modulo](BigInteger lhs, const BigInteger& rhs) {
+        lhs += rhs;
+        if (lhs >= modulo) {
+            lhs -= modulo;
+        }
+        return lhs;
     };
-    auto powResult = std::make_pair(BigInteger(1), BigInteger(0));
-    auto base = std::make_pair(a, BigInteger(1));
-    auto exp = (modulo + BigInteger(1)) / BigInteger(2);
+    auto multiplyPair = [&field, &addPair, omega = field.toMontgomery(a.square() - arg)](
+            const std::pair<BigInteger, BigInteger>& lhs, const std::pair<BigInteger, BigInteger>& rhs) {
+        return std::make_pair(addPair(field.multiply(lhs.first, rhs.first),
+                                      field.multiply(field.multiply(lhs.second, rhs.second), omega)),
+                              addPair(field.multiply(lhs.first, rhs.second), field.multiply(lhs.second, rhs.first)));
+    };
+    auto powResult = std::make_pair(field.one(), BigInteger(0));
+    auto base = std::make_pair(field.toMontgomery(a), field.one());
+    auto exp = (modulo + 1) / 2;
 
-    while (exp > BigInteger(0)) {
+    while (exp.signum() > 0) {
         if (exp.isOdd()) {
             powResult = multiplyPair(powResult, base);
         }
         base = multiplyPair(base, base);
-        exp /= BigInteger(2);
+        exp >>= 1;
     }
-    if (powResult.second == BigInteger(0)) return BigInteger(-1);
-    BigInteger ans = powResult.first;
-    if ((ans * ans) % modulo != arg) return BigInteger(-1);
+    // (a + w)^((p + 1) / 2) of a genuine root has no w component
+    if (!powResult.second.isZero()) return BigInteger(-1);
+    BigInteger ans = field.fromMontgomery(powResult.first);
+    if (ans.square() % modulo != arg % modulo) return BigInteger(-1);
     return ans;
 }
 
 std::tuple<BigInt::KeyPair, BigInt::EllipticCurve::Point, BigInt::EllipticCurve::Point> BigInt::encode(const BigInt::BigInteger &arg) {
-    if (arg > BigInteger(255) || arg < BigInteger(0)) {
+    if (arg > 255 || arg.signum() < 0) {
         throw BigInt::InvalidConsoleArguments();
     }
 
     auto encoder = new EllipticCurve();
-    auto seed = BigInteger::rand(encoder->p);
+    auto seed = BigInteger::rand(encoder->getP());
     auto basePoint = encoder->createPoint();
     auto Q = basePoint * seed;
 
     auto keyPair = BigInt::KeyPair({Q, seed});
 
-    auto sessionKey = BigInteger::rand(encoder->p);
+    auto sessionKey = BigInteger::rand(encoder->getP());
     auto M = Q * arg;
     auto a = basePoint * sessionKey;
     auto b = Q * sessionKey + M;
@@ -229,7 +266,7 @@ BigInt::decode(const BigInt::EllipticCurve::Point &a,
                const BigInt::EllipticCurve::Point &b,
                const BigInt::KeyPair& keyPair) {
     auto M = b + (a * keyPair.privateKey).inverse();
-    for (BigInteger m(0); m < BigInteger(256); m++) {
+    for (BigInteger m(0); m < 256; ++m) {
         if (keyPair.publicKey * m == M) {
             return m;
         }
@@ -237,26 +274,17 @@ BigInt::decode(const BigInt::EllipticCurve::Point &a,
     return BigInteger(-1);
 }
 
-std::ostream &BigInt::operator<<(std::ostream &os, const BigInt::EllipticCurve::Point& pt) {
-    os << "(" << pt.x << ", " << pt.y << ")";
-    return os;
-}
-
-std::ostream &BigInt::operator<<(std::ostream &os, const BigInt::EllipticCurve &pt) {
-    os << "a = " << pt.a << ", b = " << pt.b << ", p = " << pt.p;
-    return os;
-}
-
 BigInt::BigInteger BigInt::gcdExtended(const BigInt::BigInteger &a, const BigInt::BigInteger &b, BigInt::BigInteger &x,
                                        BigInt::BigInteger &y) {
-    if (a == BigInteger(0)) {
+    if (a.isZero()) {
         x = BigInteger(0);
         y = BigInteger(1);
         return b;
     }
     BigInteger x1, y1, d;
-    d = gcdExtended(b % a, a, x1, y1);
-    x = y1 - (b / a) * x1;
+    std::pair<BigInteger, BigInteger> qr = BigInt::divmod(b, a);
+    d = gcdExtended(qr.second, a, x1, y1);
+    x = y1 - qr.first * x1;
     y = x1;
     return d;
 }
@@ -264,71 +292,10 @@ BigInt::BigInteger BigInt::gcdExtended(const BigInt::BigInteger &a, const BigInt
 BigInt::BigInteger BigInt::inverseInCircle(const BigInt::BigInteger &arg, const BigInteger& modulo) {
     BigInteger x, y, g;
     g = BigInt::gcdExtended(arg, modulo, x, y);
-    if (g != BigInteger(1)) {
-        throw;
+    if (!g.isOne()) {
+        throw NotInvertibleException();
     }
     return (x + modulo) % modulo;
 }
 
-BigInt::EllipticCurve::Point
-BigInt::EllipticCurve::createPoint(const BigInt::BigInteger &x, const BigInt::BigInteger &y) {
-    return BigInt::EllipticCurve::Point(x, y, this);
-}
-
-BigInt::EllipticCurve::Point BigInt::EllipticCurve::createPoint() {
-    return BigInt::EllipticCurve::Point(this);
-}
-
-BigInt::EllipticCurve::Point BigInt::EllipticCurve::Point::operator+(const BigInt::EllipticCurve::Point &other) const {
-    Point ans(BigInteger(0), BigInteger(0), this->parent);
-    if (this->x == other.x && this->y != other.y) {
-        return ans;
-    }
-    if (this->x == BigInteger(0) && this->y == BigInteger(0)) {
-        return other;
-    }
-    if (other.x == BigInteger(0) && other.y == BigInteger(0)) {
-        return *this;
-    }
-    BigInteger slope;
-    if (*this == other) {
-        slope = BigInteger(3) * this->x * this->x + this->parent->a
-                * BigInt::inverseInCircle(BigInteger(2) * this->y , this->parent->p);
-        slope %= this->parent->p;
-    } else {
-        slope = (this->y + this->parent->p - other.y)
-                * BigInt::inverseInCircle(this->x + this->parent->p - other.x, this->parent->p);
-        slope %= this->parent->p;
-    }
-    ans.x = (slope * slope + BigInteger(2) * this->parent->p - this->x - other.x) % this->parent->p;
-    ans.y = (slope * (this->x - ans.x + this->parent->p) - this->y + this->parent->p) % this->parent->p;
-    return ans;
-}
-
-bool BigInt::EllipticCurve::Point::operator==(const BigInt::EllipticCurve::Point& other) const {
-    return (this->x == other.x && this->y == other.y);
-}
-
-BigInt::EllipticCurve::Point BigInt::EllipticCurve::Point::operator*(const BigInt::BigInteger &other) const {
-    if (other == BigInteger(1)) {
-        return *this;
-    }
-    if (other == BigInteger(0)) {
-        return Point(BigInteger(0), BigInteger(0), this->parent);
-    }
-    Point ans(BigInteger(0), BigInteger(0), this->parent);
-    Point cp(*this);
-    BigInteger exp(other);
-    while (exp != BigInteger(0)) {
-        if (exp.isOdd()) {
-            ans = ans + cp;
-        }
-        cp = cp + cp;
-        exp /= BigInteger(2);
-    }
-    return ans;
-}
-
-BigInt::EllipticCurve::Point BigInt::EllipticCurve::Point::inverse() const {
-    return BigInt::EllipticCurve::Point(x, parent->p - y, parent);
-}
+template class BigInt::BasicEllipticCurve<BigInt::FixedBigInteger<128>>;
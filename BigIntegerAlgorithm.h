@@ -6,6 +6,7 @@
 #define BIGINTEGERLAB_BIGINTEGERALGORITHM_H
 
 #include "BigInteger.h"
+#include "BigIntegerFixed.h"
 
 namespace BigInt {
     static const std::vector<BigInteger> smallPrimes({BigInteger(2), // NOLINT(cert-err58-cpp)
@@ -35,46 +36,138 @@ namespace BigInt {
     BigInteger sqrtMod(const BigInteger& arg, const BigInteger& modulo);
 
     struct KeyPair;
-    class EllipticCurve {
-        BigInteger a;
-        BigInteger b;
-        BigInteger p;
+    // Number is BigInteger or, for a field known at compile time, a FixedBigInteger wide enough for p
+    template<class Number>
+    class BasicEllipticCurve {
+        Number a;
+        Number b;
+        Number p;
     public:
-        EllipticCurve() : a(DEFAULT_CURVE_PARAM_A), b(DEFAULT_CURVE_PARAM_B), p(DEFAULT_CURVE_BASE) {}
-        EllipticCurve(const BigInteger& _a, const BigInteger& _b, const BigInteger& _p) : a(_a), b(_b), p(_p) {}
+        BasicEllipticCurve() : a(DEFAULT_CURVE_PARAM_A), b(DEFAULT_CURVE_PARAM_B), p(DEFAULT_CURVE_BASE) {}
+        BasicEllipticCurve(const Number& _a, const Number& _b, const Number& _p) : a(_a), b(_b), p(_p) {}
+        // Coordinates are expected in [0, p); (0, 0) stands for the point at infinity
         class Point {
-            BigInteger x;
-            BigInteger y;
-            EllipticCurve* parent;
+            Number x;
+            Number y;
+            BasicEllipticCurve* parent;
         public:
-            Point(const BigInteger& _x, const BigInteger& _y, EllipticCurve* _parent) :
+            Point(const Number& _x, const Number& _y, BasicEllipticCurve* _parent) :
                 x(_x), y(_y), parent(_parent) {}
             Point(const Point&) = default;
-            explicit Point(EllipticCurve* _parent) :
+            Point(Point&&) = default;
+            Point& operator=(const Point&) = default;
+            Point& operator=(Point&&) = default;
+            explicit Point(BasicEllipticCurve* _parent) :
                 x(DEFAULT_X), y(DEFAULT_Y), parent(_parent) {}
-            Point operator+(const Point& other) const;
-            Point operator*(const BigInteger& other) const;
-            bool operator==(const Point& other) const;
-            Point inverse() const;
-            friend std::ostream& operator<<(std::ostream& os, const EllipticCurve::Point& pt);
-            EllipticCurve* getParent() const {
+
+            Point operator+(const Point& other) const {
+                const Number& mod = this->parent->p;
+                Point ans(Number(), Number(), this->parent);
+                if (this->x == other.x && this->y != other.y) {
+                    return ans;
+                }
+                if (this->x.isZero() && this->y.isZero()) {
+                    return other;
+                }
+                if (other.x.isZero() && other.y.isZero()) {
+                    return *this;
+                }
+                Number slope;
+                if (*this == other) {
+                    // Tangent slope (3x^2 + a) / 2y
+                    Number square = this->x;
+                    square.mulMod(this->x, mod);
+                    Number twoY = this->y;
+                    twoY.addMod(this->y, mod);
+                    slope = this->parent->a % mod;
+                    slope.addMod(square, mod).addMod(square, mod).addMod(square, mod);
+                    slope.mulMod(inverseInCircle(twoY, mod), mod);
+                } else {
+                    Number dx = this->x;
+                    dx.subMod(other.x, mod);
+                    slope = this->y;
+                    slope.subMod(other.y, mod).mulMod(inverseInCircle(dx, mod), mod);
+                }
+                ans.x = slope;
+                ans.x.mulMod(slope, mod).subMod(this->x, mod).subMod(other.x, mod);
+                ans.y = this->x;
+                ans.y.subMod(ans.x, mod).mulMod(slope, mod).subMod(this->y, mod);
+                return ans;
+            }
+
+            Point operator*(const BigInteger& other) const {
+                if (other.isOne()) {
+                    return *this;
+                }
+                if (other.isZero()) {
+                    return Point(Number(), Number(), this->parent);
+                }
+                Point ans(Number(), Number(), this->parent);
+                Point cp(*this);
+                size_t bits = other.bitLength();
+                for (size_t i = 0; i < bits; i++) {
+                    if (other.testBit(i)) {
+                        ans = ans + cp;
+                    }
+                    cp = cp + cp;
+                }
+                return ans;
+            }
+
+            bool operator==(const Point& other) const {
+                return (this->x == other.x && this->y == other.y);
+            }
+
+            Point inverse() const {
+                Number negY = parent->p;
+                negY -= y;
+                return Point(x, negY, parent);
+            }
+
+            const Number& getX() const {
+                return x;
+            }
+            const Number& getY() const {
+                return y;
+            }
+            BasicEllipticCurve* getParent() const {
                 return parent;
             }
+
+            friend std::ostream& operator<<(std::ostream& os, const Point& pt) {
+                os << "(" << pt.x << ", " << pt.y << ")";
+                return os;
+            }
         };
-        Point createPoint(const BigInteger& x, const BigInteger& y);
-        Point createPoint();
-        friend std::tuple<BigInt::KeyPair, BigInt::EllipticCurve::Point, BigInt::EllipticCurve::Point>
-                encode(const BigInteger& arg);
-        friend BigInteger decode(const Point& a, const Point& b, const BigInt::KeyPair& keyPair);
-        friend std::ostream& operator<<(std::ostream& os, const EllipticCurve& pt);
+
+        Point createPoint(const Number& x, const Number& y) {
+            return Point(x, y, this);
+        }
+        Point createPoint() {
+            return Point(this);
+        }
+
+        const Number& getA() const {
+            return a;
+        }
+        const Number& getB() const {
+            return b;
+        }
+        const Number& getP() const {
+            return p;
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const BasicEllipticCurve& curve) {
+            os << "a = " << curve.a << ", b = " << curve.b << ", p = " << curve.p;
+            return os;
+        }
     };
+    typedef BasicEllipticCurve<BigInteger> EllipticCurve;
 
     struct KeyPair {
         EllipticCurve::Point publicKey;
         BigInteger privateKey;
     };
-    std::ostream& operator<<(std::ostream& os, const EllipticCurve::Point& pt);
-    std::ostream& operator<<(std::ostream& os, const EllipticCurve& pt);
     std::tuple<BigInt::KeyPair, BigInt::EllipticCurve::Point, BigInt::EllipticCurve::Point>
             encode(const BigInteger& arg);
     BigInteger decode(const BigInt::EllipticCurve::Point& a,
@@ -0,0 +1,130 @@
+#include "BigIntegerAllocator.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace {
+    class HeapLimbAllocator : public BigInt::LimbAllocator {
+    public:
+        BigInt::limb_t *allocate(size_t n) override {
+            return static_cast<BigInt::limb_t *>(::operator new(n * sizeof(BigInt::limb_t),
+                                                                std::align_val_t(BigInt::LIMB_ALIGNMENT)));
+        }
+
+        void deallocate(BigInt::limb_t *p, size_t) override {
+            ::operator delete(p, std::align_val_t(BigInt::LIMB_ALIGNMENT));
+        }
+    };
+
+    thread_local BigInt::LimbAllocator *current = nullptr;
+}
+
+BigInt::LimbAllocator &BigInt::defaultLimbAllocator() {
+    // Never destroyed, since static numbers may release their limbs after it would be
+    static HeapLimbAllocator *instance = new HeapLimbAllocator();
+    return *instance;
+}
+
+BigInt::LimbAllocator &BigInt::currentLimbAllocator() {
+    return current != nullptr ? *current : defaultLimbAllocator();
+}
+
+// Shared by the arena handle and every block it handed out, deleted with the last of them
+class BigInt::LimbArena::State : public BigInt::LimbAllocator {
+public:
+    explicit State(size_t chunkLimbs) : chunkLimbs(aligned(std::max<size_t>(chunkLimbs, 1))) {}
+
+    ~State() override {
+        for (const Chunk &chunk : chunks) {
+            ::operator delete(chunk.base, std::align_val_t(LIMB_ALIGNMENT));
+        }
+    }
+
+    limb_t *allocate(size_t n) override {
+        n = aligned(n);
+        if (chunks.empty() || chunks.back().size - chunks.back().top < n) {
+            size_t size = std::max(n, chunkLimbs);
+            chunks.push_back({static_cast<limb_t *>(::operator new(size * sizeof(limb_t),
+                                                                   std::align_val_t(LIMB_ALIGNMENT))), size, 0});
+        }
+        Chunk &chunk = chunks.back();
+        limb_t *p = chunk.base + chunk.top;
+        chunk.top += n;
+        used += n;
+        peak = std::max(peak, used);
+        references++;
+        return p;
+    }
+
+    void deallocate(limb_t *p, size_t n) override {
+        n = aligned(n);
+        Chunk &chunk = chunks.back();
+        if (p + n == chunk.base + chunk.top) {
+            chunk.top -= n;
+        }
+        used -= n;
+        unreference();
+    }
+
+    void unreference() {
+        if (--references == 0) {
+            delete this;
+        }
+    }
+
+    size_t used = 0;
+    size_t peak = 0;
+
+private:
+    struct Chunk {
+        limb_t *base;
+        size_t size;
+        size_t top;
+    };
+
+    // Blocks are rounded up to whole cache lines to keep the next one aligned
+    static size_t aligned(size_t n) {
+        const size_t lineLimbs = LIMB_ALIGNMENT / sizeof(limb_t);
+        return (n + lineLimbs - 1) / lineLimbs * lineLimbs;
+    }
+
+    size_t chunkLimbs;
+    std::vector<Chunk> chunks;
+    size_t references = 1;
+};
+
+BigInt::LimbArena::LimbArena(size_t chunkLimbs) : state(new State(chunkLimbs)) {}
+
+BigInt::LimbArena::~LimbArena() {
+    state->unreference();
+}
+
+BigInt::LimbAllocator &BigInt::LimbArena::allocator() {
+    return *state;
+}
+
+size_t BigInt::LimbArena::currentUsage() const {
+    return state->used * sizeof(limb_t);
+}
+
+size_t BigInt::LimbArena::peakUsage() const {
+    return state->peak * sizeof(limb_t);
+}
+
+BigInt::ScopedLimbAllocator::ScopedLimbAllocator(LimbAllocator &allocator) : previous(current), active(true) {
+    current = &allocator;
+}
+
+BigInt::ScopedLimbAllocator::ScopedLimbAllocator(LimbArena &arena) : ScopedLimbAllocator(arena.allocator()) {}
+
+BigInt::ScopedLimbAllocator::~ScopedLimbAllocator() {
+    restore();
+}
+
+void BigInt::ScopedLimbAllocator::restore() {
+    if (active) {
+        current = previous;
+        active = false;
+    }
+}
@@ -0,0 +1,72 @@
+//
+// Allocation policy for the heap blocks of BigInteger limbs.
+// Every block remembers the allocator it came from, so numbers can outlive
+// the scope that installed a custom allocator and still be freed correctly.
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERALLOCATOR_H
+#define BIGINTEGERLAB_BIGINTEGERALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BigInt {
+    typedef std::uint64_t limb_t;
+
+    // Heap blocks start on a cache line, so vector kernels never split their loads across two
+    const size_t LIMB_ALIGNMENT = 64;
+
+    class LimbAllocator {
+    public:
+        virtual ~LimbAllocator() = default;
+        virtual limb_t *allocate(size_t n) = 0;
+        virtual void deallocate(limb_t *p, size_t n) = 0;
+    };
+
+    // Plain operator new / delete, used unless something else is installed
+    LimbAllocator &defaultLimbAllocator();
+    // Allocator that new limb blocks of the calling thread come from
+    LimbAllocator &currentLimbAllocator();
+
+    // Bump allocator for the temporaries of one expensive call. Freeing the most
+    // recent block gives its memory back, anything else is reclaimed at once when
+    // the arena and every number allocated from it are gone.
+    // An arena must only be used from the thread that created it.
+    class LimbArena {
+    public:
+        static const size_t DEFAULT_CHUNK_LIMBS = 4096;
+
+        explicit LimbArena(size_t chunkLimbs = DEFAULT_CHUNK_LIMBS);
+        ~LimbArena();
+        LimbArena(const LimbArena &) = delete;
+        LimbArena &operator=(const LimbArena &) = delete;
+
+        LimbAllocator &allocator();
+        // Bytes currently handed out and the most handed out at once so far;
+        // an arena with chunks of the peak size never needs a second chunk.
+        size_t currentUsage() const;
+        size_t peakUsage() const;
+
+    private:
+        class State;
+        State *state;
+    };
+
+    // Makes the given allocator current for this thread until destroyed or restored
+    class ScopedLimbAllocator {
+    public:
+        explicit ScopedLimbAllocator(LimbAllocator &allocator);
+        explicit ScopedLimbAllocator(LimbArena &arena);
+        ~ScopedLimbAllocator();
+        ScopedLimbAllocator(const ScopedLimbAllocator &) = delete;
+        ScopedLimbAllocator &operator=(const ScopedLimbAllocator &) = delete;
+
+        void restore();
+
+    private:
+        LimbAllocator *previous;
+        bool active;
+    };
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERALLOCATOR_H
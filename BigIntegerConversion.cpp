@@ -0,0 +1,154 @@
+#include "BigIntegerKernels.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace {
+    using BigInt::limb_t;
+    using BigInt::detail::DECIMAL_CELL_LENGTH;
+    using BigInt::detail::DECIMAL_MODULO;
+
+    // Below this many limbs (or cells of digits) the quadratic cell-by-cell conversion is used
+    const size_t DECIMAL_DC_THRESHOLD = 48;
+
+    size_t trimmed(const limb_t *a, size_t n) {
+        return BigInt::detail::normalizedSize(a, n);
+    }
+
+    // 10^(DECIMAL_CELL_LENGTH * 2^k), built by repeated squaring and kept per thread.
+    // A deque keeps references to earlier powers valid while new ones are appended.
+    const std::vector<limb_t> &decimalPower(size_t k) {
+        static thread_local std::deque<std::vector<limb_t> > powers;
+        if (powers.empty()) {
+            powers.push_back({DECIMAL_MODULO});
+        }
+        while (powers.size() <= k) {
+            const std::vector<limb_t> &last = powers.back();
+            std::vector<limb_t> next(2 * last.size());
+            BigInt::detail::sqr(next.data(), last.data(), last.size());
+            next.resize(trimmed(next.data(), next.size()));
+            powers.push_back(std::move(next));
+        }
+        return powers[k];
+    }
+
+    // Largest k with DECIMAL_CELL_LENGTH * 2^k < digits, digits must exceed one cell
+    size_t splitLevel(size_t digits) {
+        size_t k = 0;
+        while ((size_t(DECIMAL_CELL_LENGTH) << (k + 1)) < digits) {
+            k++;
+        }
+        return k;
+    }
+
+    // Writes value < 10^width right-aligned into exactly width characters
+    void writeCell(char *out, size_t width, limb_t value) {
+        char cell[DECIMAL_CELL_LENGTH + 1];
+        char *end = std::to_chars(cell, cell + sizeof(cell), value).ptr;
+        size_t length = end - cell;
+        std::memset(out, '0', width - length);
+        std::memcpy(out + width - length, cell, length);
+    }
+
+    void toDecimalBasecase(char *out, size_t width, const limb_t *a, size_t n) {
+        std::vector<limb_t> rest(a, a + n);
+        char *pos = out + width;
+        while (n > 0) {
+            limb_t cell = BigInt::detail::divRem1(rest.data(), rest.data(), n, DECIMAL_MODULO);
+            n = trimmed(rest.data(), n);
+            size_t cellWidth = std::min<size_t>(DECIMAL_CELL_LENGTH, pos - out);
+            pos -= cellWidth;
+            writeCell(pos, cellWidth, cell);
+        }
+        std::memset(out, '0', pos - out);
+    }
+
+    void fromDecimalBasecase(std::vector<limb_t> &r, const char *s, size_t len) {
+        r.clear();
+        // Cells are taken from the most significant end, so the first one may be shorter
+        size_t head = len % DECIMAL_CELL_LENGTH;
+        if (head == 0) {
+            head = DECIMAL_CELL_LENGTH;
+        }
+        const char *end = s + len;
+        while (s != end) {
+            limb_t cell = 0, scale = 1;
+            for (size_t i = 0; i < head; i++, s++) {
+                cell = cell * 10 + limb_t(*s - '0');
+                scale *= 10;
+            }
+            limb_t carry = BigInt::detail::mul1(r.data(), r.data(), r.size(), scale);
+            r.push_back(carry);
+            BigInt::detail::add(r.data(), r.data(), r.size(), &cell, 1);
+            r.resize(trimmed(r.data(), r.size()));
+            head = DECIMAL_CELL_LENGTH;
+        }
+    }
+
+    void fromDecimalRecursive(std::vector<limb_t> &r, const char *s, size_t len) {
+        if (len <= DECIMAL_DC_THRESHOLD * DECIMAL_CELL_LENGTH) {
+            fromDecimalBasecase(r, s, len);
+            return;
+        }
+        // value = high * 10^lowDigits + low
+        size_t k = splitLevel(len);
+        size_t lowDigits = size_t(DECIMAL_CELL_LENGTH) << k;
+        std::vector<limb_t> high, low;
+        fromDecimalRecursive(high, s, len - lowDigits);
+        fromDecimalRecursive(low, s + len - lowDigits, lowDigits);
+        const std::vector<limb_t> &power = decimalPower(k);
+        r.assign(high.size() + power.size() + 1, 0);
+        if (!high.empty()) {
+            if (high.size() >= power.size()) {
+                BigInt::detail::mul(r.data(), high.data(), high.size(), power.data(), power.size());
+            } else {
+                BigInt::detail::mul(r.data(), power.data(), power.size(), high.data(), high.size());
+            }
+        }
+        if (!low.empty()) {
+            BigInt::detail::add(r.data(), r.data(), r.size(), low.data(), low.size());
+        }
+        r.resize(trimmed(r.data(), r.size()));
+    }
+}
+
+void BigInt::detail::toDecimal(char *out, size_t width, const limb_t *a, size_t n) {
+    n = trimmed(a, n);
+    if (n <= DECIMAL_DC_THRESHOLD || width <= DECIMAL_CELL_LENGTH) {
+        toDecimalBasecase(out, width, a, n);
+        return;
+    }
+    // a = high * 10^lowDigits + low, both halves are written independently
+    size_t k = splitLevel(width);
+    size_t lowDigits = size_t(DECIMAL_CELL_LENGTH) << k;
+    const std::vector<limb_t> &power = decimalPower(k);
+    if (n < power.size()) {
+        std::memset(out, '0', width - lowDigits);
+        toDecimal(out + width - lowDigits, lowDigits, a, n);
+        return;
+    }
+    std::vector<limb_t> high(n - power.size() + 1), low(power.size());
+    divRem(high.data(), low.data(), a, n, power.data(), power.size());
+    toDecimal(out, width - lowDigits, high.data(), high.size());
+    toDecimal(out + width - lowDigits, lowDigits, low.data(), low.size());
+}
+
+size_t BigInt::detail::decimalWidth(const limb_t *a, size_t n) {
+    n = trimmed(a, n);
+    if (n == 0) {
+        return 1;
+    }
+    size_t bits = 64 * n - __builtin_clzll(a[n - 1]);
+    // log10(2) < 0.30103, so this never undercounts
+    return bits * 30103 / 100000 + 1;
+}
+
+size_t BigInt::detail::fromDecimal(limb_t *r, const char *s, size_t len) {
+    std::vector<limb_t> value;
+    fromDecimalRecursive(value, s, len);
+    std::copy(value.begin(), value.end(), r);
+    return value.size();
+}
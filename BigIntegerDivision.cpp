@@ -0,0 +1,282 @@
+#include "BigIntegerKernels.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace {
+    using BigInt::limb_t;
+    typedef std::vector<limb_t> Limbs;
+
+    // Divisors below this many limbs, or quotients below it, are left to Algorithm D
+    const size_t BURNIKEL_ZIEGLER_THRESHOLD = 80;
+
+    void trim(Limbs &x) {
+        while (!x.empty() && x.back() == 0) {
+            x.pop_back();
+        }
+    }
+
+    // x[from, from + len) as a trimmed value
+    Limbs slice(const Limbs &x, size_t from, size_t len) {
+        if (from >= x.size()) {
+            return Limbs();
+        }
+        Limbs result(x.begin() + from, x.begin() + std::min(x.size(), from + len));
+        trim(result);
+        return result;
+    }
+
+    // high * B^shift + low, where low < B^shift
+    Limbs concat(const Limbs &high, const Limbs &low, size_t shift) {
+        if (high.empty()) {
+            return low;
+        }
+        Limbs result(shift + high.size(), 0);
+        std::copy(low.begin(), low.end(), result.begin());
+        std::copy(high.begin(), high.end(), result.begin() + shift);
+        return result;
+    }
+
+    int compare(const Limbs &x, const Limbs &y) {
+        if (x.size() != y.size()) {
+            return x.size() < y.size() ? -1 : 1;
+        }
+        return BigInt::detail::compare(x.data(), y.data(), x.size());
+    }
+
+    void addTo(Limbs &x, const Limbs &y) {
+        if (x.size() < y.size()) {
+            x.resize(y.size(), 0);
+        }
+        x.push_back(BigInt::detail::add(x.data(), x.data(), x.size(), y.data(), y.size()));
+        trim(x);
+    }
+
+    // requires x >= y
+    void subFrom(Limbs &x, const Limbs &y) {
+        BigInt::detail::sub(x.data(), x.data(), x.size(), y.data(), y.size());
+        trim(x);
+    }
+
+    Limbs product(const Limbs &x, const Limbs &y) {
+        if (x.empty() || y.empty()) {
+            return Limbs();
+        }
+        const Limbs &longer = x.size() >= y.size() ? x : y;
+        const Limbs &shorter = x.size() >= y.size() ? y : x;
+        Limbs result(x.size() + y.size());
+        BigInt::detail::mul(result.data(), longer.data(), longer.size(), shorter.data(), shorter.size());
+        trim(result);
+        return result;
+    }
+
+    std::pair<Limbs, Limbs> divide3n2n(const Limbs &a12, const Limbs &a3, const Limbs &b, size_t n);
+
+    // Divides a < b * B^n by the normalized n-limb divisor b
+    std::pair<Limbs, Limbs> divide2n1n(const Limbs &a, const Limbs &b, size_t n) {
+        if (a.size() < n || (a.size() == n && BigInt::detail::compare(a.data(), b.data(), n) < 0)) {
+            return {Limbs(), a};
+        }
+        if (n % 2 == 1 || n < BURNIKEL_ZIEGLER_THRESHOLD) {
+            Limbs q(a.size() - n + 1), r(n);
+            BigInt::detail::divRemBasecase(q.data(), r.data(), a.data(), a.size(), b.data(), n);
+            trim(q);
+            trim(r);
+            return {q, r};
+        }
+        size_t h = n / 2;
+        std::pair<Limbs, Limbs> high = divide3n2n(slice(a, n, n), slice(a, h, h), b, n);
+        std::pair<Limbs, Limbs> low = divide3n2n(high.second, slice(a, 0, h), b, n);
+        return {concat(high.first, low.first, h), low.second};
+    }
+
+    // Divides a12 * B^(n/2) + a3 < b * B^(n/2) by the normalized n-limb divisor b
+    std::pair<Limbs, Limbs> divide3n2n(const Limbs &a12, const Limbs &a3, const Limbs &b, size_t n) {
+        size_t h = n / 2;
+        Limbs b1 = slice(b, h, h), b2 = slice(b, 0, h);
+        Limbs a1 = slice(a12, h, h + 1);
+        Limbs q, c;
+        if (compare(a1, b1) < 0) {
+            std::tie(q, c) = divide2n1n(a12, b1, h);
+        } else {
+            // The quotient is at most B^h - 1, and c = a12 - (B^h - 1) * b1
+            q.assign(h, ~limb_t(0));
+            c = a12;
+            addTo(c, b1);
+            subFrom(c, concat(b1, Limbs(), h));
+        }
+        Limbs d = product(q, b2);
+        Limbs r = concat(c, a3, h);
+        // At most two corrections are needed
+        while (compare(r, d) < 0) {
+            subFrom(q, Limbs(1, 1));
+            addTo(r, b);
+        }
+        subFrom(r, d);
+        return {q, r};
+    }
+
+    // Burnikel and Ziegler, Fast Recursive Division, 1998
+    void divRemBurnikelZiegler(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+        // Pad the divisor to n = j * 2^k limbs with j below the threshold, and normalize it
+        size_t m = 1;
+        while (bn / m >= BURNIKEL_ZIEGLER_THRESHOLD) {
+            m *= 2;
+        }
+        size_t n = (bn + m - 1) / m * m;
+        size_t limbShift = n - bn;
+        unsigned bitShift = __builtin_clzll(b[bn - 1]);
+
+        Limbs bNorm(n, 0), aNorm(an + limbShift + 1, 0);
+        BigInt::detail::lshift(bNorm.data() + limbShift, b, bn, bitShift);
+        aNorm.back() = BigInt::detail::lshift(aNorm.data() + limbShift, a, an, bitShift);
+
+        // Split the dividend into t blocks of n limbs, with the top bit of the top block clear
+        size_t t = std::max<size_t>(2, (aNorm.size() + n - 1) / n);
+        aNorm.resize(t * n, 0);
+        if (aNorm.back() >> 63) {
+            t++;
+            aNorm.resize(t * n, 0);
+        }
+
+        size_t qn = an - bn + 1;
+        std::fill(q, q + qn, 0);
+        Limbs z = slice(aNorm, (t - 2) * n, 2 * n);
+        Limbs rem;
+        for (size_t i = t - 1; i-- > 0;) {
+            std::pair<Limbs, Limbs> qr = divide2n1n(z, bNorm, n);
+            for (size_t j = 0; j < qr.first.size() && i * n + j < qn; j++) {
+                q[i * n + j] = qr.first[j];
+            }
+            rem = qr.second;
+            if (i > 0) {
+                z = concat(rem, slice(aNorm, (i - 1) * n, n), n);
+            }
+        }
+
+        // Undo the normalization of the remainder
+        rem.resize(n, 0);
+        BigInt::detail::rshift(rem.data(), rem.data(), n, bitShift);
+        std::copy(rem.begin() + limbShift, rem.begin() + limbShift + bn, r);
+    }
+}
+
+void BigInt::mpn::divRem(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn,
+                          limb_t *scratch) {
+    if (bn == 1) {
+        r[0] = divRem1(q, a, an, b[0]);
+    } else if (bn < BURNIKEL_ZIEGLER_THRESHOLD || an - bn < BURNIKEL_ZIEGLER_THRESHOLD) {
+        detail::divRemBasecase(q, r, a, an, b, bn, scratch);
+    } else {
+        divRemBurnikelZiegler(q, r, a, an, b, bn);
+    }
+}
+
+size_t BigInt::mpn::divRemScratchSize(size_t an, size_t bn) {
+    // Algorithm D keeps normalized copies of both operands
+    bool basecase = bn < BURNIKEL_ZIEGLER_THRESHOLD || an - bn < BURNIKEL_ZIEGLER_THRESHOLD;
+    return bn > 1 && basecase ? an + bn + 1 : 0;
+}
+
+// Knuth, TAOCP vol. 2, 4.3.1, Algorithm D
+void BigInt::detail::divRemBasecase(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn,
+                                    limb_t *ws) {
+    if (ws == nullptr) {
+        // Scratch is kept per thread, so repeated small divisions don't allocate
+        static thread_local std::vector<limb_t> scratch;
+        scratch.resize(an + bn + 1);
+        ws = scratch.data();
+    }
+    // Normalize, so that the top limb of the divisor has its high bit set
+    unsigned shift = __builtin_clzll(b[bn - 1]);
+    limb_t *u = ws, *v = ws + an + 1;
+    lshift(v, b, bn, shift);
+    u[an] = lshift(u, a, an, shift);
+
+    const limb_t v1 = v[bn - 1], v2 = v[bn - 2];
+    for (size_t j = an - bn + 1; j-- > 0;) {
+        // Estimate the quotient limb from the top two limbs of the remainder,
+        // then correct it with the second limb of the divisor. It can only be one too large afterwards.
+        double_limb_t numerator = ((double_limb_t)u[j + bn] << 64) | u[j + bn - 1];
+        double_limb_t qhat, rhat;
+        if (u[j + bn] >= v1) {
+            qhat = ~limb_t(0);
+            rhat = numerator - qhat * v1;
+        } else {
+            qhat = numerator / v1;
+            rhat = numerator % v1;
+        }
+        while (rhat >> 64 == 0 && qhat * v2 > ((rhat << 64) | u[j + bn - 2])) {
+            qhat--;
+            rhat += v1;
+        }
+
+        limb_t borrow = subMul1(u + j, v, bn, (limb_t)qhat);
+        bool negative = u[j + bn] < borrow;
+        u[j + bn] -= borrow;
+        if (negative) {
+            qhat--;
+            u[j + bn] += addN(u + j, u + j, v, bn);
+        }
+        q[j] = (limb_t)qhat;
+    }
+    rshift(r, u, bn, shift);
+}
+
+// Jebelean, An Algorithm for Exact Division, 1993. The quotient is found from the low limb up:
+// each limb is the remainder's low limb times the inverse of b modulo 2^64, no estimate is ever wrong.
+// Only the low an - bn + 1 limbs of the remainder matter, so q holds them and is overwritten in place.
+void BigInt::mpn::divExact(limb_t *q, const limb_t *a, size_t an, const limb_t *b, size_t bn, limb_t *scratch) {
+    // Zero limbs at the bottom of b are zero in a as well and don't change the quotient
+    while (b[0] == 0) {
+        a++, an--;
+        b++, bn--;
+    }
+    size_t qn = an - bn + 1, low = std::min(bn, qn);
+    // An even divisor is made odd by shifting both numbers, the shifted-out bits of a are zero
+    unsigned shift = __builtin_ctzll(b[0]);
+    LimbBuffer buffer;
+    if (shift != 0) {
+        if (scratch == nullptr) {
+            buffer.resize(low + 1);
+            scratch = buffer.data();
+        }
+        // Both only matter up to the limbs that reach the quotient
+        rshift(scratch, b, std::min(bn, low + 1), shift);
+        b = scratch;
+        rshift(q, a, qn, shift);
+        if (an > qn) {
+            q[qn - 1] |= a[qn] << (64 - shift);
+        }
+    } else {
+        std::copy(a, a + qn, q);
+    }
+
+    limb_t inverse = detail::inverseLimb(b[0]);
+    if (low == 1) {
+        // With a single limb of b the whole subtraction is one high product carried into the next limb
+        limb_t d = b[0], borrow = 0;
+        for (size_t i = 0; i < qn; i++) {
+            limb_t cur = q[i];
+            limb_t x = cur - borrow;
+            q[i] = x * inverse;
+            borrow = limb_t(((detail::double_limb_t)q[i] * d) >> 64) + (cur < borrow);
+        }
+        return;
+    }
+    for (size_t i = 0; i < qn; i++) {
+        limb_t qi = q[i] * inverse;
+        size_t len = std::min(low, qn - i);
+        limb_t borrow = subMul1(q + i, b, len, qi);
+        for (size_t j = i + len; borrow != 0 && j < qn; j++) {
+            limb_t cur = q[j];
+            q[j] = cur - borrow;
+            borrow = cur < borrow;
+        }
+        q[i] = qi;
+    }
+}
+
+size_t BigInt::mpn::divExactScratchSize(size_t an, size_t bn) {
+    return std::min(bn, an - bn + 1) + 1;
+}
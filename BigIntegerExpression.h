@@ -0,0 +1,219 @@
+//
+// Opt-in lazy arithmetic over BigInteger. lazy(x) starts an expression tree of
+// +, - , * and %, which is only evaluated when assigned to a BigInteger:
+//
+//     x = (lazy(x) * x + one) % n;
+//
+// A product on the right of + or - is folded into the left value with addMul/subMul,
+// and a product reduced by % goes through mulMod, so neither is materialised on its own.
+// Lvalue operands are referenced and rvalue ones are moved into the tree.
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGEREXPRESSION_H
+#define BIGINTEGERLAB_BIGINTEGEREXPRESSION_H
+
+#include "BigInteger.h"
+
+namespace BigInt {
+    namespace expr {
+        struct Ref {
+            const BigInteger *value;
+        };
+
+        struct Value {
+            BigInteger value;
+        };
+
+        template<class L, class R>
+        struct Add {
+            L lhs;
+            R rhs;
+        };
+
+        template<class L, class R>
+        struct Sub {
+            L lhs;
+            R rhs;
+        };
+
+        template<class L, class R>
+        struct Mul {
+            L lhs;
+            R rhs;
+        };
+
+        template<class L, class R>
+        struct Mod {
+            L lhs;
+            R rhs;
+        };
+
+        template<>
+        struct IsExpression<Ref> : std::true_type {};
+        template<>
+        struct IsExpression<Value> : std::true_type {};
+        template<class L, class R>
+        struct IsExpression<Add<L, R> > : std::true_type {};
+        template<class L, class R>
+        struct IsExpression<Sub<L, R> > : std::true_type {};
+        template<class L, class R>
+        struct IsExpression<Mul<L, R> > : std::true_type {};
+        template<class L, class R>
+        struct IsExpression<Mod<L, R> > : std::true_type {};
+
+        inline Ref wrap(const BigInteger &x) {
+            return Ref{&x};
+        }
+
+        inline Value wrap(BigInteger &&x) {
+            return Value{std::move(x)};
+        }
+
+        template<class E, class = typename std::enable_if<IsExpression<typename std::decay<E>::type>::value>::type>
+        typename std::decay<E>::type wrap(E &&e) {
+            return std::forward<E>(e);
+        }
+
+        template<class L, class R>
+        using EnableIfExpression = typename std::enable_if<
+                IsExpression<typename std::decay<L>::type>::value ||
+                IsExpression<typename std::decay<R>::type>::value>::type;
+
+        template<class L, class R, class = EnableIfExpression<L, R> >
+        Add<decltype(wrap(std::declval<L>())), decltype(wrap(std::declval<R>()))> operator+(L &&lhs, R &&rhs) {
+            return {wrap(std::forward<L>(lhs)), wrap(std::forward<R>(rhs))};
+        }
+
+        template<class L, class R, class = EnableIfExpression<L, R> >
+        Sub<decltype(wrap(std::declval<L>())), decltype(wrap(std::declval<R>()))> operator-(L &&lhs, R &&rhs) {
+            return {wrap(std::forward<L>(lhs)), wrap(std::forward<R>(rhs))};
+        }
+
+        template<class L, class R, class = EnableIfExpression<L, R> >
+        Mul<decltype(wrap(std::declval<L>())), decltype(wrap(std::declval<R>()))> operator*(L &&lhs, R &&rhs) {
+            return {wrap(std::forward<L>(lhs)), wrap(std::forward<R>(rhs))};
+        }
+
+        template<class L, class R, class = EnableIfExpression<L, R> >
+        Mod<decltype(wrap(std::declval<L>())), decltype(wrap(std::declval<R>()))> operator%(L &&lhs, R &&rhs) {
+            return {wrap(std::forward<L>(lhs)), wrap(std::forward<R>(rhs))};
+        }
+
+        // Whether evaluating into dst could overwrite an operand before it is read
+        inline bool refersTo(const Ref &e, const BigInteger *dst) {
+            return e.value == dst;
+        }
+
+        inline bool refersTo(const Value &, const BigInteger *) {
+            return false;
+        }
+
+        template<template<class, class> class Node, class L, class R>
+        bool refersTo(const Node<L, R> &e, const BigInteger *dst) {
+            return refersTo(e.lhs, dst) || refersTo(e.rhs, dst);
+        }
+
+        // Evaluators below require that dst is not referenced by the expression
+        inline void evaluate(BigInteger &dst, const Ref &e) {
+            dst = *e.value;
+        }
+
+        inline void evaluate(BigInteger &dst, const Value &e) {
+            dst = e.value;
+        }
+
+        template<template<class, class> class Node, class L, class R>
+        void evaluate(BigInteger &dst, const Node<L, R> &e);
+
+        // Leaves are used as they are, anything else is evaluated into the scratch number
+        inline const BigInteger &operand(const Ref &e, BigInteger &) {
+            return *e.value;
+        }
+
+        inline const BigInteger &operand(const Value &e, BigInteger &) {
+            return e.value;
+        }
+
+        template<class E>
+        const BigInteger &operand(const E &e, BigInteger &scratch) {
+            evaluate(scratch, e);
+            return scratch;
+        }
+
+        template<class L, class R>
+        void evaluateNode(BigInteger &dst, const Add<L, R> &e) {
+            evaluate(dst, e.lhs);
+            BigInteger scratch;
+            dst += operand(e.rhs, scratch);
+        }
+
+        template<class L, class A, class B>
+        void evaluateNode(BigInteger &dst, const Add<L, Mul<A, B> > &e) {
+            evaluate(dst, e.lhs);
+            BigInteger scratchA, scratchB;
+            dst.addMul(operand(e.rhs.lhs, scratchA), operand(e.rhs.rhs, scratchB));
+        }
+
+        template<class L, class R>
+        void evaluateNode(BigInteger &dst, const Sub<L, R> &e) {
+            evaluate(dst, e.lhs);
+            BigInteger scratch;
+            dst -= operand(e.rhs, scratch);
+        }
+
+        template<class L, class A, class B>
+        void evaluateNode(BigInteger &dst, const Sub<L, Mul<A, B> > &e) {
+            evaluate(dst, e.lhs);
+            BigInteger scratchA, scratchB;
+            dst.subMul(operand(e.rhs.lhs, scratchA), operand(e.rhs.rhs, scratchB));
+        }
+
+        template<class L, class R>
+        void evaluateNode(BigInteger &dst, const Mul<L, R> &e) {
+            evaluate(dst, e.lhs);
+            BigInteger scratch;
+            dst *= operand(e.rhs, scratch);
+        }
+
+        template<class L, class R>
+        void evaluateNode(BigInteger &dst, const Mod<L, R> &e) {
+            evaluate(dst, e.lhs);
+            BigInteger scratch;
+            dst %= operand(e.rhs, scratch);
+        }
+
+        template<class A, class B, class R>
+        void evaluateNode(BigInteger &dst, const Mod<Mul<A, B>, R> &e) {
+            evaluate(dst, e.lhs.lhs);
+            BigInteger scratchB, scratchM;
+            dst.mulMod(operand(e.lhs.rhs, scratchB), operand(e.rhs, scratchM));
+        }
+
+        template<template<class, class> class Node, class L, class R>
+        void evaluate(BigInteger &dst, const Node<L, R> &e) {
+            evaluateNode(dst, e);
+        }
+
+        template<class E>
+        void assign(BigInteger &dst, const E &e) {
+            if (refersTo(e, &dst)) {
+                BigInteger result;
+                evaluate(result, e);
+                dst = std::move(result);
+            } else {
+                evaluate(dst, e);
+            }
+        }
+    }
+
+    // Starts a lazy expression; the referenced number must outlive it
+    inline expr::Ref lazy(const BigInteger &x) {
+        return expr::wrap(x);
+    }
+
+    inline expr::Value lazy(BigInteger &&x) {
+        return expr::wrap(std::move(x));
+    }
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGEREXPRESSION_H
@@ -0,0 +1,341 @@
+//
+// Non-negative integers of a width fixed at compile time, for code such as
+// elliptic-curve arithmetic whose numbers never outgrow a known field size.
+// The limbs live inside the object, so nothing allocates, and every kernel
+// is constexpr with loop bounds the compiler knows. Bits is rounded up to
+// whole limbs; +, - and * wrap around modulo 2^(64 LIMBS).
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERFIXED_H
+#define BIGINTEGERLAB_BIGINTEGERFIXED_H
+
+#include "BigInteger.h"
+
+namespace BigInt {
+    namespace detail {
+        typedef unsigned __int128 double_limb_t;
+
+        constexpr limb_t fixedAddN(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+            limb_t carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                double_limb_t sum = (double_limb_t)a[i] + b[i] + carry;
+                r[i] = (limb_t)sum;
+                carry = (limb_t)(sum >> 64);
+            }
+            return carry;
+        }
+
+        constexpr limb_t fixedSubN(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+            limb_t borrow = 0;
+            for (size_t i = 0; i < n; i++) {
+                limb_t cur = a[i];
+                r[i] = cur - b[i] - borrow;
+                borrow = cur < b[i] || cur - b[i] < borrow;
+            }
+            return borrow;
+        }
+
+        constexpr size_t fixedNormalizedSize(const limb_t *a, size_t n) {
+            while (n > 0 && a[n - 1] == 0) {
+                n--;
+            }
+            return n;
+        }
+
+        // Algorithm D as in detail::divRemBasecase: q[0, an - n + 1) = a / m and r[0, n) = a % m
+        // for an >= n >= 1 and m[n - 1] != 0, with u[0, an + 1) and v[0, n) as workspace
+        constexpr void fixedDivRem(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *m, size_t n,
+                                   limb_t *u, limb_t *v) {
+            if (n == 1) {
+                double_limb_t rem = 0;
+                for (size_t i = an; i-- > 0;) {
+                    double_limb_t cur = (rem << 64) | a[i];
+                    q[i] = (limb_t)(cur / m[0]);
+                    rem = cur % m[0];
+                }
+                r[0] = (limb_t)rem;
+                return;
+            }
+            unsigned shift = __builtin_clzll(m[n - 1]);
+            for (size_t i = n; i-- > 0;) {
+                v[i] = (m[i] << shift) | (shift != 0 && i > 0 ? m[i - 1] >> (64 - shift) : 0);
+            }
+            u[an] = shift != 0 ? a[an - 1] >> (64 - shift) : 0;
+            for (size_t i = an; i-- > 0;) {
+                u[i] = (a[i] << shift) | (shift != 0 && i > 0 ? a[i - 1] >> (64 - shift) : 0);
+            }
+
+            for (size_t j = an - n + 1; j-- > 0;) {
+                double_limb_t numerator = ((double_limb_t)u[j + n] << 64) | u[j + n - 1];
+                double_limb_t qhat = 0, rhat = 0;
+                if (u[j + n] >= v[n - 1]) {
+                    qhat = ~limb_t(0);
+                    rhat = numerator - qhat * v[n - 1];
+                } else {
+                    qhat = numerator / v[n - 1];
+                    rhat = numerator % v[n - 1];
+                }
+                while (rhat >> 64 == 0 && qhat * v[n - 2] > ((rhat << 64) | u[j + n - 2])) {
+                    qhat--;
+                    rhat += v[n - 1];
+                }
+
+                limb_t carry = 0, borrow = 0;
+                for (size_t i = 0; i < n; i++) {
+                    double_limb_t product = qhat * v[i] + carry;
+                    carry = (limb_t)(product >> 64);
+                    limb_t low = (limb_t)product, cur = u[j + i];
+                    u[j + i] = cur - low - borrow;
+                    borrow = cur < low || cur - low < borrow;
+                }
+                limb_t top = u[j + n];
+                u[j + n] = top - carry - borrow;
+                if (top < (double_limb_t)carry + borrow) {
+                    qhat--;
+                    u[j + n] += fixedAddN(u + j, u + j, v, n);
+                }
+                q[j] = (limb_t)qhat;
+            }
+            for (size_t i = 0; i < n; i++) {
+                r[i] = (u[i] >> shift) | (shift != 0 ? u[i + 1] << (64 - shift) : 0);
+            }
+        }
+    }
+
+    template<size_t Bits>
+    class FixedBigInteger {
+        static_assert(Bits > 0, "FixedBigInteger needs at least one bit");
+
+    public:
+        static constexpr size_t LIMBS = (Bits + 63) / 64;
+
+        constexpr FixedBigInteger() : limbs() {}
+        constexpr explicit FixedBigInteger(limb_t value) : limbs() {
+            limbs[0] = value;
+        }
+        // Throws IntegerOverflowException for negative values and values of more than 64 LIMBS bits
+        explicit FixedBigInteger(const BigInteger &value) : limbs() {
+            if (value.sign == MINUS || value.data.size() > LIMBS) {
+                throw IntegerOverflowException();
+            }
+            for (size_t i = 0; i < value.data.size(); i++) {
+                limbs[i] = value.data[i];
+            }
+        }
+
+        BigInteger toBigInteger() const {
+            BigInteger result;
+            result.data.assign(limbs, limbs + LIMBS);
+            result.cleanup_zeroes();
+            return result;
+        }
+
+        constexpr const limb_t *data() const {
+            return limbs;
+        }
+
+        constexpr bool isZero() const {
+            return detail::fixedNormalizedSize(limbs, LIMBS) == 0;
+        }
+
+        constexpr bool isOdd() const {
+            return (limbs[0] & 1) != 0;
+        }
+
+        constexpr size_t bitLength() const {
+            size_t n = detail::fixedNormalizedSize(limbs, LIMBS);
+            return n == 0 ? 0 : 64 * n - __builtin_clzll(limbs[n - 1]);
+        }
+
+        constexpr bool testBit(size_t bit) const {
+            return bit < 64 * LIMBS && ((limbs[bit / 64] >> (bit % 64)) & 1) != 0;
+        }
+
+        constexpr int compare(const FixedBigInteger &rhs) const {
+            for (size_t i = LIMBS; i-- > 0;) {
+                if (limbs[i] != rhs.limbs[i]) {
+                    return limbs[i] < rhs.limbs[i] ? -1 : 1;
+                }
+            }
+            return 0;
+        }
+
+        friend constexpr bool operator==(const FixedBigInteger &lhs, const FixedBigInteger &rhs) {
+            return lhs.compare(rhs) == 0;
+        }
+        friend constexpr bool operator!=(const FixedBigInteger &lhs, const FixedBigInteger &rhs) {
+            return lhs.compare(rhs) != 0;
+        }
+        friend constexpr bool operator<(const FixedBigInteger &lhs, const FixedBigInteger &rhs) {
+            return lhs.compare(rhs) < 0;
+        }
+        friend constexpr bool operator<=(const FixedBigInteger &lhs, const FixedBigInteger &rhs) {
+            return lhs.compare(rhs) <= 0;
+        }
+        friend constexpr bool operator>(const FixedBigInteger &lhs, const FixedBigInteger &rhs) {
+            return lhs.compare(rhs) > 0;
+        }
+        friend constexpr bool operator>=(const FixedBigInteger &lhs, const FixedBigInteger &rhs) {
+            return lhs.compare(rhs) >= 0;
+        }
+
+        constexpr FixedBigInteger &operator+=(const FixedBigInteger &rhs) {
+            detail::fixedAddN(limbs, limbs, rhs.limbs, LIMBS);
+            return *this;
+        }
+
+        constexpr FixedBigInteger &operator-=(const FixedBigInteger &rhs) {
+            detail::fixedSubN(limbs, limbs, rhs.limbs, LIMBS);
+            return *this;
+        }
+
+        // Only the low LIMBS limbs of the product are formed
+        constexpr FixedBigInteger &operator*=(const FixedBigInteger &rhs) {
+            limb_t product[LIMBS] = {};
+            for (size_t i = 0; i < LIMBS; i++) {
+                limb_t carry = 0;
+                for (size_t j = 0; i + j < LIMBS; j++) {
+                    detail::double_limb_t cur = (detail::double_limb_t)limbs[i] * rhs.limbs[j] + product[i + j] + carry;
+                    product[i + j] = (limb_t)cur;
+                    carry = (limb_t)(cur >> 64);
+                }
+            }
+            for (size_t i = 0; i < LIMBS; i++) {
+                limbs[i] = product[i];
+            }
+            return *this;
+        }
+
+        constexpr FixedBigInteger operator+(const FixedBigInteger &rhs) const {
+            FixedBigInteger result = *this;
+            return result += rhs;
+        }
+
+        constexpr FixedBigInteger operator-(const FixedBigInteger &rhs) const {
+            FixedBigInteger result = *this;
+            return result -= rhs;
+        }
+
+        constexpr FixedBigInteger operator*(const FixedBigInteger &rhs) const {
+            FixedBigInteger result = *this;
+            return result *= rhs;
+        }
+
+        // The whole product, which needs twice the limbs
+        constexpr FixedBigInteger<128 * LIMBS> fullProduct(const FixedBigInteger &rhs) const {
+            FixedBigInteger<128 * LIMBS> result;
+            for (size_t i = 0; i < LIMBS; i++) {
+                limb_t carry = 0;
+                for (size_t j = 0; j < LIMBS; j++) {
+                    detail::double_limb_t cur = (detail::double_limb_t)limbs[i] * rhs.limbs[j] +
+                                                result.limbs[i + j] + carry;
+                    result.limbs[i + j] = (limb_t)cur;
+                    carry = (limb_t)(cur >> 64);
+                }
+                result.limbs[i + LIMBS] = carry;
+            }
+            return result;
+        }
+
+        // Quotient and remainder by a divisor of any width; throws DivisionByZeroException for zero
+        template<size_t DivisorBits>
+        constexpr void divide(const FixedBigInteger<DivisorBits> &divisor, FixedBigInteger *quotient,
+                              FixedBigInteger<DivisorBits> *remainder) const {
+            constexpr size_t DIVISOR_LIMBS = FixedBigInteger<DivisorBits>::LIMBS;
+            size_t n = detail::fixedNormalizedSize(divisor.limbs, DIVISOR_LIMBS);
+            if (n == 0) {
+                throw DivisionByZeroException();
+            }
+            size_t an = detail::fixedNormalizedSize(limbs, LIMBS);
+            limb_t q[LIMBS] = {}, r[DIVISOR_LIMBS] = {};
+            if (an < n) {
+                for (size_t i = 0; i < an; i++) {
+                    r[i] = limbs[i];
+                }
+            } else {
+                limb_t u[LIMBS + 1] = {}, v[DIVISOR_LIMBS] = {};
+                detail::fixedDivRem(q, r, limbs, an, divisor.limbs, n, u, v);
+            }
+            if (quotient != nullptr) {
+                for (size_t i = 0; i < LIMBS; i++) {
+                    quotient->limbs[i] = q[i];
+                }
+            }
+            if (remainder != nullptr) {
+                for (size_t i = 0; i < DIVISOR_LIMBS; i++) {
+                    remainder->limbs[i] = r[i];
+                }
+            }
+        }
+
+        template<size_t DivisorBits>
+        constexpr FixedBigInteger operator/(const FixedBigInteger<DivisorBits> &rhs) const {
+            FixedBigInteger result;
+            divide<DivisorBits>(rhs, &result, nullptr);
+            return result;
+        }
+
+        template<size_t DivisorBits>
+        constexpr FixedBigInteger<DivisorBits> operator%(const FixedBigInteger<DivisorBits> &rhs) const {
+            FixedBigInteger<DivisorBits> result;
+            divide(rhs, nullptr, &result);
+            return result;
+        }
+
+        // Counterparts of BigInteger::addMod, subMod and mulMod; addMod and subMod need both operands in [0, modulo)
+        constexpr FixedBigInteger &addMod(const FixedBigInteger &rhs, const FixedBigInteger &modulo) {
+            limb_t carry = detail::fixedAddN(limbs, limbs, rhs.limbs, LIMBS);
+            if (carry != 0 || *this >= modulo) {
+                detail::fixedSubN(limbs, limbs, modulo.limbs, LIMBS);
+            }
+            return *this;
+        }
+
+        constexpr FixedBigInteger &subMod(const FixedBigInteger &rhs, const FixedBigInteger &modulo) {
+            if (detail::fixedSubN(limbs, limbs, rhs.limbs, LIMBS) != 0) {
+                detail::fixedAddN(limbs, limbs, modulo.limbs, LIMBS);
+            }
+            return *this;
+        }
+
+        constexpr FixedBigInteger &mulMod(const FixedBigInteger &rhs, const FixedBigInteger &modulo) {
+            return *this = fullProduct(rhs) % modulo;
+        }
+
+    private:
+        limb_t limbs[LIMBS];
+
+        template<size_t OtherBits>
+        friend class FixedBigInteger;
+    };
+
+    // arg^-1 modulo modulo by the extended Euclidean algorithm, with the coefficient of arg
+    // kept reduced so it never leaves the fixed width. Throws NotInvertibleException.
+    template<size_t Bits>
+    constexpr FixedBigInteger<Bits> inverseInCircle(const FixedBigInteger<Bits> &arg,
+                                                    const FixedBigInteger<Bits> &modulo) {
+        FixedBigInteger<Bits> r0 = modulo, r1 = arg % modulo;
+        FixedBigInteger<Bits> x0, x1(1);
+        while (!r1.isZero()) {
+            FixedBigInteger<Bits> q, r2;
+            r0.divide(r1, &q, &r2);
+            FixedBigInteger<Bits> x2 = x0;
+            x2.subMod((q % modulo).mulMod(x1, modulo), modulo);
+            r0 = r1;
+            r1 = r2;
+            x0 = x1;
+            x1 = x2;
+        }
+        if (r0 != FixedBigInteger<Bits>(1)) {
+            throw NotInvertibleException();
+        }
+        return x0;
+    }
+
+    template<size_t Bits>
+    std::ostream &operator<<(std::ostream &os, const FixedBigInteger<Bits> &value) {
+        return os << value.toBigInteger();
+    }
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERFIXED_H
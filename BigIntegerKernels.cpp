@@ -0,0 +1,358 @@
+#include "BigIntegerKernels.h"
+
+#include <algorithm>
+
+// Carry chains, SIMD compares and mulx are selected by CPUID on first use;
+// everything else builds the portable loops only.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BIGINTEGERLAB_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+    using BigInt::limb_t;
+    using BigInt::detail::double_limb_t;
+
+    int compareGeneric(const limb_t *a, const limb_t *b, size_t n) {
+        for (size_t i = n; i-- > 0;) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    size_t normalizedSizeGeneric(const limb_t *a, size_t n) {
+        while (n > 0 && a[n - 1] == 0) {
+            n--;
+        }
+        return n;
+    }
+
+    limb_t addNWithCarry(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t carry) {
+        for (size_t i = 0; i < n; i++) {
+            limb_t cur = a[i] + carry;
+            carry = cur < carry;
+            cur += b[i];
+            carry += cur < b[i];
+            r[i] = cur;
+        }
+        return carry;
+    }
+
+    limb_t subNWithBorrow(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t borrow) {
+        for (size_t i = 0; i < n; i++) {
+            limb_t cur = a[i] - b[i];
+            limb_t next_borrow = a[i] < b[i];
+            next_borrow += cur < borrow;
+            r[i] = cur - borrow;
+            borrow = next_borrow;
+        }
+        return borrow;
+    }
+
+    limb_t addNGeneric(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+        return addNWithCarry(r, a, b, n, 0);
+    }
+
+    limb_t subNGeneric(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+        return subNWithBorrow(r, a, b, n, 0);
+    }
+
+    limb_t mul1Generic(limb_t *r, const limb_t *a, size_t n, limb_t b) {
+        limb_t carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            double_limb_t cur = (double_limb_t)a[i] * b + carry;
+            r[i] = (limb_t)cur;
+            carry = (limb_t)(cur >> 64);
+        }
+        return carry;
+    }
+
+#ifdef BIGINTEGERLAB_X86_KERNELS
+    // adc / sbb chains, part of the x86-64 baseline
+    limb_t addNCarry(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+        unsigned char carry = 0;
+        unsigned long long s0, s1, s2, s3;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            carry = _addcarry_u64(carry, a[i], b[i], &s0);
+            carry = _addcarry_u64(carry, a[i + 1], b[i + 1], &s1);
+            carry = _addcarry_u64(carry, a[i + 2], b[i + 2], &s2);
+            carry = _addcarry_u64(carry, a[i + 3], b[i + 3], &s3);
+            r[i] = s0;
+            r[i + 1] = s1;
+            r[i + 2] = s2;
+            r[i + 3] = s3;
+        }
+        for (; i < n; i++) {
+            carry = _addcarry_u64(carry, a[i], b[i], &s0);
+            r[i] = s0;
+        }
+        return carry;
+    }
+
+    limb_t subNBorrow(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+        unsigned char borrow = 0;
+        unsigned long long s0, s1, s2, s3;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            borrow = _subborrow_u64(borrow, a[i], b[i], &s0);
+            borrow = _subborrow_u64(borrow, a[i + 1], b[i + 1], &s1);
+            borrow = _subborrow_u64(borrow, a[i + 2], b[i + 2], &s2);
+            borrow = _subborrow_u64(borrow, a[i + 3], b[i + 3], &s3);
+            r[i] = s0;
+            r[i + 1] = s1;
+            r[i + 2] = s2;
+            r[i + 3] = s3;
+        }
+        for (; i < n; i++) {
+            borrow = _subborrow_u64(borrow, a[i], b[i], &s0);
+            r[i] = s0;
+        }
+        return borrow;
+    }
+
+    // Same loop, but the compiler may use mulx, which leaves the flags alone
+    __attribute__((target("bmi2")))
+    limb_t mul1BMI2(limb_t *r, const limb_t *a, size_t n, limb_t b) {
+        limb_t carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            double_limb_t cur = (double_limb_t)a[i] * b + carry;
+            r[i] = (limb_t)cur;
+            carry = (limb_t)(cur >> 64);
+        }
+        return carry;
+    }
+
+    __attribute__((target("avx2")))
+    int compareAVX2(const limb_t *a, const limb_t *b, size_t n) {
+        for (; n >= 4; n -= 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + n - 4));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + n - 4));
+            unsigned equal = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, y)));
+            if (equal != 0xF) {
+                size_t i = n - 4 + (31 - __builtin_clz(~equal & 0xF));
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return compareGeneric(a, b, n);
+    }
+
+    __attribute__((target("avx2")))
+    size_t normalizedSizeAVX2(const limb_t *a, size_t n) {
+        for (; n >= 4; n -= 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + n - 4));
+            if (!_mm256_testz_si256(x, x)) {
+                break;
+            }
+        }
+        return normalizedSizeGeneric(a, n);
+    }
+
+    __attribute__((target("avx512f")))
+    int compareAVX512(const limb_t *a, const limb_t *b, size_t n) {
+        for (; n >= 8; n -= 8) {
+            __m512i x = _mm512_loadu_si512(a + n - 8);
+            __m512i y = _mm512_loadu_si512(b + n - 8);
+            unsigned differ = _mm512_cmpneq_epu64_mask(x, y);
+            if (differ != 0) {
+                size_t i = n - 8 + (31 - __builtin_clz(differ));
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return compareGeneric(a, b, n);
+    }
+
+    __attribute__((target("avx512f")))
+    size_t normalizedSizeAVX512(const limb_t *a, size_t n) {
+        for (; n >= 8; n -= 8) {
+            __m512i x = _mm512_loadu_si512(a + n - 8);
+            if (_mm512_test_epi64_mask(x, x) != 0) {
+                break;
+            }
+        }
+        return normalizedSizeGeneric(a, n);
+    }
+
+    // Vector additions resolve the carries between lanes with one integer addition over lane masks:
+    // with generate the lanes whose sum wrapped and propagate the lanes whose sum is all ones,
+    // (generate << 1 | carry) + propagate flips exactly the propagate bits a carry runs through.
+    __attribute__((target("avx512f")))
+    limb_t addNAVX512(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+        const __m512i ones = _mm512_set1_epi64(-1);
+        unsigned carry = 0;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i s = _mm512_add_epi64(x, _mm512_loadu_si512(b + i));
+            unsigned generate = _mm512_cmplt_epu64_mask(s, x);
+            unsigned propagate = _mm512_cmpeq_epu64_mask(s, ones);
+            unsigned chain = (((generate << 1) & 0xFF) | carry) + propagate;
+            carry = (chain >> 8) | (generate >> 7);
+            // Lanes that receive a carry get one more, which is subtracting all ones
+            s = _mm512_mask_sub_epi64(s, (__mmask8)(chain ^ propagate), s, ones);
+            _mm512_storeu_si512(r + i, s);
+        }
+        return addNWithCarry(r + i, a + i, b + i, n - i, carry);
+    }
+
+    __attribute__((target("avx512f")))
+    limb_t subNAVX512(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+        const __m512i ones = _mm512_set1_epi64(-1);
+        unsigned borrow = 0;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            __m512i d = _mm512_sub_epi64(x, y);
+            unsigned generate = _mm512_cmplt_epu64_mask(x, y);
+            unsigned propagate = _mm512_cmpeq_epu64_mask(d, _mm512_setzero_si512());
+            unsigned chain = (((generate << 1) & 0xFF) | borrow) + propagate;
+            borrow = (chain >> 8) | (generate >> 7);
+            d = _mm512_mask_add_epi64(d, (__mmask8)(chain ^ propagate), d, ones);
+            _mm512_storeu_si512(r + i, d);
+        }
+        return subNWithBorrow(r + i, a + i, b + i, n - i, borrow);
+    }
+#endif
+
+    struct Kernels {
+        int (*compare)(const limb_t *, const limb_t *, size_t);
+        size_t (*normalizedSize)(const limb_t *, size_t);
+        limb_t (*addN)(limb_t *, const limb_t *, const limb_t *, size_t);
+        limb_t (*subN)(limb_t *, const limb_t *, const limb_t *, size_t);
+        limb_t (*mul1)(limb_t *, const limb_t *, size_t, limb_t);
+    };
+
+    Kernels selectKernels() {
+        Kernels kernels = {compareGeneric, normalizedSizeGeneric, addNGeneric, subNGeneric, mul1Generic};
+#ifdef BIGINTEGERLAB_X86_KERNELS
+        __builtin_cpu_init();
+        kernels.addN = addNCarry;
+        kernels.subN = subNBorrow;
+        if (__builtin_cpu_supports("bmi2")) {
+            kernels.mul1 = mul1BMI2;
+        }
+        // Four lanes are too few for the vector carry resolution to beat adc, so AVX2 only compares
+        if (__builtin_cpu_supports("avx2")) {
+            kernels.compare = compareAVX2;
+            kernels.normalizedSize = normalizedSizeAVX2;
+        }
+        if (__builtin_cpu_supports("avx512f")) {
+            kernels.compare = compareAVX512;
+            kernels.normalizedSize = normalizedSizeAVX512;
+            kernels.addN = addNAVX512;
+            kernels.subN = subNAVX512;
+        }
+#endif
+        return kernels;
+    }
+
+    const Kernels &kernels() {
+        static const Kernels selected = selectKernels();
+        return selected;
+    }
+}
+
+int BigInt::mpn::compare(const limb_t *a, const limb_t *b, size_t n) {
+    return kernels().compare(a, b, n);
+}
+
+size_t BigInt::mpn::normalizedSize(const limb_t *a, size_t n) {
+    return kernels().normalizedSize(a, n);
+}
+
+BigInt::limb_t BigInt::mpn::addN(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return kernels().addN(r, a, b, n);
+}
+
+BigInt::limb_t BigInt::mpn::subN(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return kernels().subN(r, a, b, n);
+}
+
+BigInt::limb_t BigInt::mpn::add(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    limb_t carry = addN(r, a, b, bn);
+    for (size_t i = bn; i < an; i++) {
+        r[i] = a[i] + carry;
+        carry = r[i] < carry;
+    }
+    return carry;
+}
+
+BigInt::limb_t BigInt::mpn::sub(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    limb_t borrow = subN(r, a, b, bn);
+    for (size_t i = bn; i < an; i++) {
+        limb_t cur = a[i];
+        r[i] = cur - borrow;
+        borrow = cur < borrow;
+    }
+    return borrow;
+}
+
+BigInt::limb_t BigInt::mpn::mul1(limb_t *r, const limb_t *a, size_t n, limb_t b) {
+    return kernels().mul1(r, a, n, b);
+}
+
+BigInt::limb_t BigInt::mpn::addMul1(limb_t *r, const limb_t *a, size_t n, limb_t b) {
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        double_limb_t cur = (double_limb_t)a[i] * b + r[i] + carry;
+        r[i] = (limb_t)cur;
+        carry = (limb_t)(cur >> 64);
+    }
+    return carry;
+}
+
+BigInt::limb_t BigInt::mpn::subMul1(limb_t *r, const limb_t *a, size_t n, limb_t b) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        double_limb_t cur = (double_limb_t)a[i] * b + borrow;
+        limb_t low = (limb_t)cur;
+        borrow = (limb_t)(cur >> 64) + (r[i] < low);
+        r[i] -= low;
+    }
+    return borrow;
+}
+
+BigInt::limb_t BigInt::mpn::divRem1(limb_t *q, const limb_t *a, size_t n, limb_t d) {
+    double_limb_t rem = 0;
+    for (size_t i = n; i-- > 0;) {
+        double_limb_t cur = (rem << 64) | a[i];
+        q[i] = (limb_t)(cur / d);
+        rem = cur % d;
+    }
+    return (limb_t)rem;
+}
+
+BigInt::limb_t BigInt::mpn::lshift(limb_t *r, const limb_t *a, size_t n, unsigned cnt) {
+    if (n == 0) {
+        return 0;
+    }
+    if (cnt == 0) {
+        std::copy_backward(a, a + n, r + n);
+        return 0;
+    }
+    limb_t out = a[n - 1] >> (64 - cnt);
+    for (size_t i = n - 1; i > 0; i--) {
+        r[i] = (a[i] << cnt) | (a[i - 1] >> (64 - cnt));
+    }
+    r[0] = a[0] << cnt;
+    return out;
+}
+
+BigInt::limb_t BigInt::mpn::rshift(limb_t *r, const limb_t *a, size_t n, unsigned cnt) {
+    if (n == 0) {
+        return 0;
+    }
+    if (cnt == 0) {
+        std::copy(a, a + n, r);
+        return 0;
+    }
+    limb_t out = a[0] << (64 - cnt);
+    for (size_t i = 0; i + 1 < n; i++) {
+        r[i] = (a[i] >> cnt) | (a[i + 1] << (64 - cnt));
+    }
+    r[n - 1] = a[n - 1] >> cnt;
+    return out;
+}
@@ -0,0 +1,128 @@
+//
+// Internal limb kernels shared by the BigInteger translation units, on top
+// of the public span layer in BigIntegerMpn.h.
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERKERNELS_H
+#define BIGINTEGERLAB_BIGINTEGERKERNELS_H
+
+#include "BigInteger.h"
+#include "BigIntegerMpn.h"
+
+namespace BigInt {
+    namespace detail {
+        typedef unsigned __int128 double_limb_t;
+
+        // Decimal digits are converted in cells of DECIMAL_CELL_LENGTH, the most that fit a limb
+        const int DECIMAL_CELL_LENGTH = 19;
+        const limb_t DECIMAL_MODULO = 10000000000000000000ULL;
+
+        // The span kernels are public in mpn, the algorithm variants below stay internal
+        using mpn::compare;
+        using mpn::normalizedSize;
+        using mpn::addN;
+        using mpn::subN;
+        using mpn::add;
+        using mpn::sub;
+        using mpn::mul1;
+        using mpn::addMul1;
+        using mpn::subMul1;
+        using mpn::divRem1;
+        using mpn::lshift;
+        using mpn::rshift;
+        using mpn::mul;
+        using mpn::sqr;
+        using mpn::divRem;
+
+        // Same contracts as mpn::mul and mpn::sqr. The Karatsuba variants take a workspace
+        // of mpn::mulScratchSize(an, bn) (mpn::sqrScratchSize(n)) limbs or allocate one.
+        void mulBasecase(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+        void mulKaratsuba(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn, limb_t *ws = nullptr);
+        void mulToom3(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+        void mulFFT(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+        void mulNTT(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+        void sqrBasecase(limb_t *r, const limb_t *a, size_t n);
+        void sqrKaratsuba(limb_t *r, const limb_t *a, size_t n, limb_t *ws = nullptr);
+        void sqrToom3(limb_t *r, const limb_t *a, size_t n);
+        void sqrFFT(limb_t *r, const limb_t *a, size_t n);
+        void sqrNTT(limb_t *r, const limb_t *a, size_t n);
+
+        // Algorithm D for mpn::divRem, with a workspace of an + bn + 1 limbs or per-thread buffers
+        void divRemBasecase(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn,
+                            limb_t *ws = nullptr);
+
+        // a^-1 mod 2^64 for odd a. a * a = 1 mod 8, and every Newton step doubles the number of correct low bits.
+        inline limb_t inverseLimb(limb_t a) {
+            limb_t inverse = a;
+            for (int i = 0; i < 5; i++) {
+                inverse *= 2 - a * inverse;
+            }
+            return inverse;
+        }
+
+        // Writes a < 10^width as exactly width digits, padded with leading zeros
+        void toDecimal(char *out, size_t width, const limb_t *a, size_t n);
+        // Number of digits that is enough to write a in decimal
+        size_t decimalWidth(const limb_t *a, size_t n);
+        // Parses len digits into r[0, len / DECIMAL_CELL_LENGTH + 1) and returns the trimmed length
+        size_t fromDecimal(limb_t *r, const char *s, size_t len);
+
+        // Bits per window of sliding-window exponentiation, balancing the 2^(w-1) table entries
+        // against the one multiplication per w + 1 exponent bits that the windows cost
+        inline unsigned powWindowBits(size_t expBits) {
+            static const size_t limits[] = {7, 36, 140, 450, 1303, 3529};
+            unsigned w = 1;
+            while (w <= 6 && expBits > limits[w - 1]) {
+                w++;
+            }
+            return w;
+        }
+
+        // base^exp for exp > 0 by left-to-right sliding windows over a table of odd powers.
+        // mul(x, y) sets x = x * y and sqr(x) sets x = x * x, both in whatever ring the caller works in.
+        template<class Mul, class Sqr>
+        BigInteger windowPow(const BigInteger &base, const BigInteger &exp, Mul mul, Sqr sqr) {
+            size_t bits = exp.bitLength();
+            unsigned w = powWindowBits(bits);
+            std::vector<BigInteger> odd(size_t(1) << (w - 1), base);
+            if (odd.size() > 1) {
+                BigInteger baseSquared = base;
+                sqr(baseSquared);
+                for (size_t k = 1; k < odd.size(); k++) {
+                    mul(odd[k] = odd[k - 1], baseSquared);
+                }
+            }
+            BigInteger result;
+            bool first = true;
+            for (size_t i = bits; i-- > 0;) {
+                if (!exp.testBit(i)) {
+                    sqr(result);
+                    continue;
+                }
+                // The longest window ending at bit i that also starts at a set bit
+                size_t j = i + 1 >= w ? i + 1 - w : 0;
+                while (!exp.testBit(j)) {
+                    j++;
+                }
+                size_t value = 0;
+                for (size_t k = i + 1; k-- > j;) {
+                    value = 2 * value + exp.testBit(k);
+                }
+                if (first) {
+                    result = odd[value / 2];
+                    first = false;
+                } else {
+                    for (size_t k = j; k <= i; k++) {
+                        sqr(result);
+                    }
+                    mul(result, odd[value / 2]);
+                }
+                i = j;
+            }
+            return result;
+        }
+    }
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERKERNELS_H
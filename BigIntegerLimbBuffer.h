@@ -0,0 +1,171 @@
+//
+// Limb storage of a BigInteger. Magnitudes of up to INLINE_LIMBS limbs are kept
+// inside the object, so small numbers and loop counters never touch the heap.
+// Longer ones move to a heap block from the current LimbAllocator, which is
+// reused as long as it is big enough.
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERLIMBBUFFER_H
+#define BIGINTEGERLAB_BIGINTEGERLIMBBUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+
+#include "BigIntegerAllocator.h"
+
+namespace BigInt {
+    class LimbBuffer {
+    public:
+        static const size_t INLINE_LIMBS = 4;
+
+        LimbBuffer() noexcept : length(0), capacity_(INLINE_LIMBS) {}
+
+        LimbBuffer(const LimbBuffer &other) : LimbBuffer() {
+            assign(other.begin(), other.end());
+        }
+
+        LimbBuffer(LimbBuffer &&other) noexcept : LimbBuffer() {
+            steal(other);
+        }
+
+        explicit LimbBuffer(size_t n) : LimbBuffer() {
+            resize(n);
+        }
+
+        template<class InputIt>
+        LimbBuffer(InputIt first, InputIt last) : LimbBuffer() {
+            assign(first, last);
+        }
+
+        ~LimbBuffer() {
+            release();
+        }
+
+        LimbBuffer &operator=(const LimbBuffer &other) {
+            if (this != &other) {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        LimbBuffer &operator=(LimbBuffer &&other) noexcept {
+            if (this != &other) {
+                if (other.isInline()) {
+                    // Keeps our own heap block, if any, for later growth
+                    std::memcpy(data(), other.storage.local, other.length * sizeof(limb_t));
+                    length = other.length;
+                    other.length = 0;
+                } else {
+                    release();
+                    steal(other);
+                }
+            }
+            return *this;
+        }
+
+        size_t size() const { return length; }
+        size_t capacity() const { return capacity_; }
+        bool empty() const { return length == 0; }
+
+        limb_t *data() { return isInline() ? storage.local : storage.heap.limbs; }
+        const limb_t *data() const { return isInline() ? storage.local : storage.heap.limbs; }
+        limb_t *begin() { return data(); }
+        limb_t *end() { return data() + length; }
+        const limb_t *begin() const { return data(); }
+        const limb_t *end() const { return data() + length; }
+
+        limb_t &operator[](size_t i) { return data()[i]; }
+        const limb_t &operator[](size_t i) const { return data()[i]; }
+        limb_t &back() { return data()[length - 1]; }
+        const limb_t &back() const { return data()[length - 1]; }
+
+        void reserve(size_t n) {
+            if (n > capacity_) {
+                reallocate(std::max(n, 2 * capacity_));
+            }
+        }
+
+        void resize(size_t n, limb_t value = 0) {
+            reserve(n);
+            if (n > length) {
+                std::fill(data() + length, data() + n, value);
+            }
+            length = n;
+        }
+
+        void push_back(limb_t value) {
+            reserve(length + 1);
+            data()[length++] = value;
+        }
+
+        void pop_back() { length--; }
+        void clear() { length = 0; }
+
+        // The source range must not point into this buffer
+        template<class InputIt>
+        void assign(InputIt first, InputIt last) {
+            size_t n = std::distance(first, last);
+            if (n > capacity_) {
+                length = 0;
+                reallocate(n);
+            }
+            std::copy(first, last, data());
+            length = n;
+        }
+
+        bool operator==(const LimbBuffer &rhs) const {
+            return length == rhs.length && std::equal(begin(), end(), rhs.begin());
+        }
+
+        bool operator!=(const LimbBuffer &rhs) const {
+            return !(*this == rhs);
+        }
+
+    private:
+        size_t length;
+        size_t capacity_;
+        union {
+            struct {
+                limb_t *limbs;
+                LimbAllocator *owner;
+            } heap;
+            limb_t local[INLINE_LIMBS];
+        } storage;
+
+        bool isInline() const { return capacity_ == INLINE_LIMBS; }
+
+        void reallocate(size_t n) {
+            LimbAllocator &allocator = currentLimbAllocator();
+            limb_t *block = allocator.allocate(n);
+            std::memcpy(block, data(), length * sizeof(limb_t));
+            release();
+            storage.heap.limbs = block;
+            storage.heap.owner = &allocator;
+            capacity_ = n;
+        }
+
+        void release() {
+            if (!isInline()) {
+                storage.heap.owner->deallocate(storage.heap.limbs, capacity_);
+            }
+            capacity_ = INLINE_LIMBS;
+        }
+
+        // Takes over the contents of other, this buffer must not own a heap block
+        void steal(LimbBuffer &other) {
+            if (other.isInline()) {
+                std::memcpy(storage.local, other.storage.local, other.length * sizeof(limb_t));
+            } else {
+                storage.heap = other.storage.heap;
+                capacity_ = other.capacity_;
+                other.capacity_ = INLINE_LIMBS;
+            }
+            length = other.length;
+            other.length = 0;
+        }
+    };
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERLIMBBUFFER_H
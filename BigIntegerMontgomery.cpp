@@ -0,0 +1,110 @@
+#include "BigIntegerMontgomery.h"
+#include "BigIntegerKernels.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+    std::vector<BigInt::limb_t> &reductionScratch() {
+        static thread_local std::vector<BigInt::limb_t> scratch;
+        return scratch;
+    }
+}
+
+BigInt::MontgomeryContext::MontgomeryContext(const BigInt::BigInteger &modulo) : m(modulo) {
+    if (m.sign == MINUS || !m.isOdd() || m.isOne()) {
+        throw InvalidModulusException();
+    }
+    inverse = limb_t(0) - detail::inverseLimb(m.data[0]);
+    rSquared = (BigInteger(1) << (2 * BigInteger::LIMB_BITS * m.data.size())) % m;
+    rModulo = fromMontgomery(rSquared);
+}
+
+const BigInt::BigInteger &BigInt::MontgomeryContext::modulo() const {
+    return m;
+}
+
+void BigInt::MontgomeryContext::reduce(limb_t *t, BigInt::BigInteger &result) const {
+    size_t n = m.data.size();
+    const limb_t *mod = m.data.data();
+    // Each step clears the lowest limb by adding a multiple of m, the carry out of t[i + n] moves up with i
+    limb_t high = 0;
+    for (size_t i = 0; i < n; i++) {
+        limb_t carry = detail::addMul1(t + i, mod, n, t[i] * inverse);
+        detail::double_limb_t sum = (detail::double_limb_t)t[i + n] + carry + high;
+        t[i + n] = (limb_t)sum;
+        high = (limb_t)(sum >> 64);
+    }
+    // t[n, 2n) + high * R is below 2m now
+    limb_t *r = t + n;
+    if (high != 0 || detail::compare(r, mod, n) >= 0) {
+        detail::subN(r, r, mod, n);
+    }
+    result.data.assign(r, r + n);
+    result.sign = PLUS;
+    result.cleanup_zeroes();
+}
+
+void BigInt::MontgomeryContext::multiplyInto(BigInt::BigInteger &result, const BigInt::BigInteger &a,
+                                             const BigInt::BigInteger &b) const {
+    // The product is followed by the workspace of the multiplication, so neither allocates once warmed up
+    size_t n = m.data.size();
+    const LimbBuffer &x = a.data.size() >= b.data.size() ? a.data : b.data;
+    const LimbBuffer &y = a.data.size() >= b.data.size() ? b.data : a.data;
+    std::vector<limb_t> &t = reductionScratch();
+    t.resize(2 * n + (&a == &b ? mpn::sqrScratchSize(x.size()) : mpn::mulScratchSize(x.size(), y.size())));
+    std::fill(t.begin(), t.begin() + 2 * n, 0);
+    if (!y.empty()) {
+        if (&a == &b) {
+            mpn::sqr(t.data(), x.data(), x.size(), t.data() + 2 * n);
+        } else {
+            mpn::mul(t.data(), x.data(), x.size(), y.data(), y.size(), t.data() + 2 * n);
+        }
+    }
+    reduce(t.data(), result);
+}
+
+BigInt::BigInteger BigInt::MontgomeryContext::toMontgomery(const BigInt::BigInteger &x) const {
+    BigInt::BigInteger result = x % m;
+    multiplyInto(result, result, rSquared);
+    return result;
+}
+
+BigInt::BigInteger BigInt::MontgomeryContext::fromMontgomery(const BigInt::BigInteger &x) const {
+    std::vector<limb_t> &t = reductionScratch();
+    t.assign(2 * m.data.size(), 0);
+    std::copy(x.data.begin(), x.data.end(), t.begin());
+    BigInt::BigInteger result;
+    reduce(t.data(), result);
+    return result;
+}
+
+const BigInt::BigInteger &BigInt::MontgomeryContext::one() const {
+    return rModulo;
+}
+
+BigInt::BigInteger BigInt::MontgomeryContext::multiply(const BigInt::BigInteger &a, const BigInt::BigInteger &b) const {
+    BigInt::BigInteger result;
+    multiplyInto(result, a, b);
+    return result;
+}
+
+BigInt::BigInteger BigInt::MontgomeryContext::square(const BigInt::BigInteger &a) const {
+    BigInt::BigInteger result;
+    multiplyInto(result, a, a);
+    return result;
+}
+
+BigInt::BigInteger BigInt::MontgomeryContext::pow(const BigInt::BigInteger &a, const BigInt::BigInteger &exp) const {
+    if (exp.signum() <= 0) {
+        return rModulo;
+    }
+    return detail::windowPow(a, exp,
+                             [this](BigInteger &x, const BigInteger &y) { multiplyInto(x, x, y); },
+                             [this](BigInteger &x) { multiplyInto(x, x, x); });
+}
+
+BigInt::BigInteger BigInt::MontgomeryContext::modPow(const BigInt::BigInteger &base,
+                                                     const BigInt::BigInteger &exp) const {
+    return fromMontgomery(pow(toMontgomery(base), exp));
+}
@@ -0,0 +1,50 @@
+//
+// Montgomery arithmetic modulo a fixed odd number m of n limbs, with R = 2^(64 n).
+// A residue x is kept as x * R mod m, in which form a product is reduced by
+// REDC, a pass of limb multiply-adds, instead of a division by m.
+// Build one context per modulus and reuse it for every operation.
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERMONTGOMERY_H
+#define BIGINTEGERLAB_BIGINTEGERMONTGOMERY_H
+
+#include "BigInteger.h"
+
+namespace BigInt {
+    class MontgomeryContext {
+    public:
+        // Throws InvalidModulusException unless the modulus is odd and above one
+        explicit MontgomeryContext(const BigInteger &modulo);
+
+        const BigInteger &modulo() const;
+
+        // Conversions between ordinary residues and Montgomery form; any x is reduced first
+        BigInteger toMontgomery(const BigInteger &x) const;
+        BigInteger fromMontgomery(const BigInteger &x) const;
+
+        // Operations on numbers in Montgomery form, which must lie in [0, m); results stay in it
+        const BigInteger &one() const;
+        BigInteger multiply(const BigInteger &a, const BigInteger &b) const;
+        BigInteger square(const BigInteger &a) const;
+        // exp must not be negative
+        BigInteger pow(const BigInteger &a, const BigInteger &exp) const;
+
+        // base^exp mod m for an ordinary base and exp >= 0
+        BigInteger modPow(const BigInteger &base, const BigInteger &exp) const;
+
+    private:
+        BigInteger m;
+        // -m^-1 mod 2^64
+        limb_t inverse;
+        // R mod m and R^2 mod m
+        BigInteger rModulo;
+        BigInteger rSquared;
+
+        // result = t * R^-1 mod m for t < m R, given as 2n limbs that are overwritten
+        void reduce(limb_t *t, BigInteger &result) const;
+        // result = a * b * R^-1 mod m, result may alias a or b
+        void multiplyInto(BigInteger &result, const BigInteger &a, const BigInteger &b) const;
+    };
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERMONTGOMERY_H
@@ -0,0 +1,66 @@
+//
+// Low-level layer under BigInteger: arithmetic on little-endian spans of limbs,
+// in the manner of GMP's mpn functions. The caller provides every output buffer,
+// so code that keeps numbers in its own arrays needs no BigInteger temporaries.
+// An output span may be the same as an input span of add, sub and the _1 functions,
+// but must not overlap the operands of a product or a division.
+//
+// Products and divisions take an optional scratch buffer of the size returned by the
+// matching ...ScratchSize function. With it, products below the Toom-3 threshold and
+// divisions below the Burnikel-Ziegler threshold run without allocating; bigger ones
+// and calls without scratch find their own temporaries. Scratch sizes depend on the
+// multiplication thresholds and are only valid until these change.
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERMPN_H
+#define BIGINTEGERLAB_BIGINTEGERMPN_H
+
+#include "BigIntegerAllocator.h"
+
+namespace BigInt {
+    namespace mpn {
+        int compare(const limb_t *a, const limb_t *b, size_t n);
+        // n without the zero limbs at the top of a
+        size_t normalizedSize(const limb_t *a, size_t n);
+
+        // r[0, n) = a + b (a - b), returns the carry (borrow) out of the top limb
+        limb_t addN(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+        limb_t subN(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+        // The same for an >= bn, r has an limbs
+        limb_t add(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+        limb_t sub(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+        // r[0, n) = a * b, r[0, n) += a * b and r[0, n) -= a * b, returning the high limb
+        limb_t mul1(limb_t *r, const limb_t *a, size_t n, limb_t b);
+        limb_t addMul1(limb_t *r, const limb_t *a, size_t n, limb_t b);
+        limb_t subMul1(limb_t *r, const limb_t *a, size_t n, limb_t b);
+        // q[0, n) = a / d, returns a % d
+        limb_t divRem1(limb_t *q, const limb_t *a, size_t n, limb_t d);
+
+        // Shifts by 0 <= cnt < 64 bits, returning the bits shifted out.
+        // lshift may write above a and rshift below it, so whole limbs can be shifted in place.
+        limb_t lshift(limb_t *r, const limb_t *a, size_t n, unsigned cnt);
+        limb_t rshift(limb_t *r, const limb_t *a, size_t n, unsigned cnt);
+
+        // r[0, an + bn) = a * b, requires an >= bn >= 1
+        void mul(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn, limb_t *scratch = nullptr);
+        size_t mulScratchSize(size_t an, size_t bn);
+        // r[0, 2n) = a^2, requires n >= 1
+        void sqr(limb_t *r, const limb_t *a, size_t n, limb_t *scratch = nullptr);
+        size_t sqrScratchSize(size_t n);
+
+        // q[0, an - bn + 1) = a / b and r[0, bn) = a % b,
+        // requires an >= bn >= 1 and a nonzero top limb of b
+        void divRem(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn,
+                    limb_t *scratch = nullptr);
+        size_t divRemScratchSize(size_t an, size_t bn);
+
+        // q[0, an - bn + 1) = a / b when b divides a, by Hensel division from the low end.
+        // Requires an >= bn >= 1 and a nonzero top limb of b; the quotient is unspecified if the division is not exact.
+        // Linear time for a single-limb divisor, quadratic without the quotient estimates of divRem otherwise.
+        void divExact(limb_t *q, const limb_t *a, size_t an, const limb_t *b, size_t bn, limb_t *scratch = nullptr);
+        size_t divExactScratchSize(size_t an, size_t bn);
+    }
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERMPN_H
@@ -0,0 +1,768 @@
+#include "BigIntegerKernels.h"
+#include "BigIntegerThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+namespace {
+    using BigInt::limb_t;
+    using BigInt::LimbBuffer;
+    using BigInt::detail::double_limb_t;
+
+    BigInt::MultiplicationThresholds thresholds = {32, 1024, 4096}; // NOLINT(cert-err58-cpp)
+
+    // Toom-3 products of at least this many limbs in the shorter operand compute their
+    // five sub-products on the thread pool; below it the tasks cost more than they save
+    const size_t PARALLEL_TOOM3_LIMBS = 2048;
+
+    // Signed magnitude used by the Toom-3 evaluation and interpolation steps.
+    struct SignedLimbs {
+        std::vector<limb_t> mag;
+        bool negative = false;
+    };
+
+    void normalize(SignedLimbs &x) {
+        while (!x.mag.empty() && x.mag.back() == 0) {
+            x.mag.pop_back();
+        }
+        if (x.mag.empty()) {
+            x.negative = false;
+        }
+    }
+
+    SignedLimbs fromSpan(const limb_t *a, size_t n) {
+        SignedLimbs result;
+        result.mag.assign(a, a + n);
+        normalize(result);
+        return result;
+    }
+
+    int compareMagnitude(const SignedLimbs &x, const SignedLimbs &y) {
+        if (x.mag.size() != y.mag.size()) {
+            return x.mag.size() < y.mag.size() ? -1 : 1;
+        }
+        return BigInt::detail::compare(x.mag.data(), y.mag.data(), x.mag.size());
+    }
+
+    SignedLimbs addSigned(const SignedLimbs &x, const SignedLimbs &y, bool negateY = false) {
+        bool yNegative = y.negative != negateY;
+        SignedLimbs result;
+        if (x.negative == yNegative) {
+            const SignedLimbs &longer = x.mag.size() >= y.mag.size() ? x : y;
+            const SignedLimbs &shorter = x.mag.size() >= y.mag.size() ? y : x;
+            result.mag.resize(longer.mag.size() + 1);
+            result.mag.back() = BigInt::detail::add(result.mag.data(), longer.mag.data(), longer.mag.size(),
+                                                    shorter.mag.data(), shorter.mag.size());
+            result.negative = x.negative;
+        } else if (compareMagnitude(x, y) >= 0) {
+            result.mag.resize(x.mag.size());
+            BigInt::detail::sub(result.mag.data(), x.mag.data(), x.mag.size(), y.mag.data(), y.mag.size());
+            result.negative = x.negative;
+        } else {
+            result.mag.resize(y.mag.size());
+            BigInt::detail::sub(result.mag.data(), y.mag.data(), y.mag.size(), x.mag.data(), x.mag.size());
+            result.negative = yNegative;
+        }
+        normalize(result);
+        return result;
+    }
+
+    SignedLimbs mulSigned(const SignedLimbs &x, const SignedLimbs &y) {
+        SignedLimbs result;
+        if (x.mag.empty() || y.mag.empty()) {
+            return result;
+        }
+        const SignedLimbs &longer = x.mag.size() >= y.mag.size() ? x : y;
+        const SignedLimbs &shorter = x.mag.size() >= y.mag.size() ? y : x;
+        result.mag.resize(x.mag.size() + y.mag.size());
+        BigInt::detail::mul(result.mag.data(), longer.mag.data(), longer.mag.size(),
+                            shorter.mag.data(), shorter.mag.size());
+        result.negative = x.negative != y.negative;
+        normalize(result);
+        return result;
+    }
+
+    SignedLimbs sqrSigned(const SignedLimbs &x) {
+        SignedLimbs result;
+        if (x.mag.empty()) {
+            return result;
+        }
+        result.mag.resize(2 * x.mag.size());
+        BigInt::detail::sqr(result.mag.data(), x.mag.data(), x.mag.size());
+        normalize(result);
+        return result;
+    }
+
+    SignedLimbs mulSmall(const SignedLimbs &x, limb_t factor) {
+        SignedLimbs result = x;
+        result.mag.push_back(BigInt::detail::mul1(result.mag.data(), x.mag.data(), x.mag.size(), factor));
+        normalize(result);
+        return result;
+    }
+
+    SignedLimbs divExactSmall(const SignedLimbs &x, limb_t divisor) {
+        SignedLimbs result = x;
+        BigInt::detail::divRem1(result.mag.data(), x.mag.data(), x.mag.size(), divisor);
+        normalize(result);
+        return result;
+    }
+
+    // r[offset, rn) += x, the sum is known to fit into rn limbs
+    void addAt(limb_t *r, size_t rn, size_t offset, const SignedLimbs &x) {
+        if (x.mag.empty()) {
+            return;
+        }
+        BigInt::detail::add(r + offset, r + offset, rn - offset, x.mag.data(), x.mag.size());
+    }
+
+    void runSubProducts(const std::function<void()> *products, size_t count, size_t limbs) {
+        if (limbs >= PARALLEL_TOOM3_LIMBS) {
+            BigInt::detail::parallelInvoke(products, count);
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            products[i]();
+        }
+    }
+
+    // Splits the longer operand into pieces of bn limbs and accumulates the partial products.
+    template<class MulFunction>
+    void mulUnbalanced(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn,
+                       limb_t *tmp, MulFunction mulFunction) {
+        mulFunction(r, a, bn, b, bn);
+        for (size_t i = bn; i < an; i += bn) {
+            size_t len = std::min(bn, an - i);
+            if (len == bn) {
+                mulFunction(tmp, a + i, len, b, bn);
+            } else {
+                mulFunction(tmp, b, bn, a + i, len);
+            }
+            limb_t carry = BigInt::detail::addN(r + i, r + i, tmp, bn);
+            for (size_t j = bn; j < len + bn; j++) {
+                r[i + j] = tmp[j] + carry;
+                carry = r[i + j] < carry;
+            }
+        }
+    }
+
+    // mpn::mul as a MulFunction, without its scratch argument
+    void mulAny(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+        BigInt::mpn::mul(r, a, an, b, bn);
+    }
+
+    // Sets r[0, h) = |a - b| for spans of at most h limbs and returns whether a < b.
+    bool absDiff(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn, size_t h) {
+        while (an > 0 && a[an - 1] == 0) an--;
+        while (bn > 0 && b[bn - 1] == 0) bn--;
+        bool less = an < bn || (an == bn && BigInt::detail::compare(a, b, an) < 0);
+        if (less) {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        BigInt::detail::sub(r, a, an, b, bn);
+        std::fill(r + an, r + h, 0);
+        return less;
+    }
+
+    void karatsuba(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn, limb_t *ws) {
+        if (bn < std::max<size_t>(thresholds.karatsuba, 2)) {
+            BigInt::detail::mulBasecase(r, a, an, b, bn);
+            return;
+        }
+        size_t h = (an + 1) / 2;
+        if (bn <= h) {
+            limb_t *tmp = ws;
+            limb_t *rest = ws + 2 * bn;
+            mulUnbalanced(r, a, an, b, bn, tmp, [rest](limb_t *r, const limb_t *a, size_t an,
+                                                       const limb_t *b, size_t bn) {
+                karatsuba(r, a, an, b, bn, rest);
+            });
+            return;
+        }
+        size_t n1a = an - h, n1b = bn - h;
+        limb_t *da = ws;
+        limb_t *db = ws + h;
+        limb_t *t = ws + 2 * h;
+        limb_t *rest = ws + 4 * h;
+
+        bool negA = absDiff(da, a, h, a + h, n1a, h);
+        bool negB = absDiff(db, b, h, b + h, n1b, h);
+        karatsuba(r, a, h, b, h, rest);
+        karatsuba(r + 2 * h, a + h, n1a, b + h, n1b, rest);
+        karatsuba(t, da, h, db, h, rest);
+
+        // a0 * b1 + a1 * b0 = a0 * b0 + a1 * b1 - (a0 - a1) * (b0 - b1)
+        limb_t *m = rest;
+        m[2 * h] = BigInt::detail::add(m, r, 2 * h, r + 2 * h, n1a + n1b);
+        if (negA == negB) {
+            m[2 * h] -= BigInt::detail::subN(m, m, t, 2 * h);
+        } else {
+            m[2 * h] += BigInt::detail::addN(m, m, t, 2 * h);
+        }
+        size_t ml = 2 * h + 1;
+        while (ml > 0 && m[ml - 1] == 0) ml--;
+        BigInt::detail::add(r + h, r + h, an + bn - h, m, ml);
+    }
+
+    // Same as karatsuba with a == b: a0 * a1 * 2 = a0^2 + a1^2 - (a0 - a1)^2 needs three squares.
+    void karatsubaSquare(limb_t *r, const limb_t *a, size_t n, limb_t *ws) {
+        if (n < std::max<size_t>(thresholds.karatsuba, 2)) {
+            BigInt::detail::sqrBasecase(r, a, n);
+            return;
+        }
+        size_t h = (n + 1) / 2, n1 = n - h;
+        limb_t *d = ws;
+        limb_t *t = ws + h;
+        limb_t *rest = ws + 3 * h;
+
+        absDiff(d, a, h, a + h, n1, h);
+        karatsubaSquare(r, a, h, rest);
+        karatsubaSquare(r + 2 * h, a + h, n1, rest);
+        karatsubaSquare(t, d, h, rest);
+
+        limb_t *m = rest;
+        m[2 * h] = BigInt::detail::add(m, r, 2 * h, r + 2 * h, 2 * n1);
+        m[2 * h] -= BigInt::detail::subN(m, m, t, 2 * h);
+        size_t ml = 2 * h + 1;
+        while (ml > 0 && m[ml - 1] == 0) ml--;
+        BigInt::detail::add(r + h, r + h, 2 * n - h, m, ml);
+    }
+
+    // Toom-3 evaluation at 0, 1, -1, -2 and infinity
+    struct Toom3Points {
+        SignedLimbs p0, p1, pm1, pm2, pinf;
+    };
+
+    Toom3Points toom3Evaluate(const limb_t *a, size_t an, size_t k) {
+        Toom3Points points;
+        SignedLimbs a1 = fromSpan(a + k, k);
+        points.p0 = fromSpan(a, k);
+        points.pinf = fromSpan(a + 2 * k, an - 2 * k);
+        SignedLimbs t = addSigned(points.p0, points.pinf);
+        points.p1 = addSigned(t, a1);
+        points.pm1 = addSigned(t, a1, true);
+        points.pm2 = addSigned(mulSmall(addSigned(points.pm1, points.pinf), 2), points.p0, true);
+        return points;
+    }
+
+    // Interpolation sequence by Bodrato, the products are given as values at the Toom3Points
+    void toom3Interpolate(limb_t *r, size_t rn, size_t k, Toom3Points &v) {
+        SignedLimbs r3 = divExactSmall(addSigned(v.pm2, v.p1, true), 3);
+        SignedLimbs r1 = divExactSmall(addSigned(v.p1, v.pm1, true), 2);
+        SignedLimbs r2 = addSigned(v.pm1, v.p0, true);
+        r3 = addSigned(divExactSmall(addSigned(r2, r3, true), 2), mulSmall(v.pinf, 2));
+        r2 = addSigned(addSigned(r2, r1), v.pinf, true);
+        r1 = addSigned(r1, r3, true);
+
+        std::fill(r, r + rn, 0);
+        std::copy(v.p0.mag.begin(), v.p0.mag.end(), r);
+        addAt(r, rn, k, r1);
+        addAt(r, rn, 2 * k, r2);
+        addAt(r, rn, 3 * k, r3);
+        addAt(r, rn, 4 * k, v.pinf);
+    }
+
+    // Multiplies without the NaN/Inf recovery of std::complex operator*, which is not needed here
+    // and keeps the butterflies from being inlined.
+    inline BigInt::fft_base complexMultiply(const BigInt::fft_base &a, const BigInt::fft_base &b) {
+        return BigInt::fft_base(a.real() * b.real() - a.imag() * b.imag(),
+                                a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    // Roots of unity for every transform level, roots[len / 2 + j] = exp(2 * pi * i * j / len).
+    // Only the top level is computed with cos/sin, lower levels are copied from it, so every
+    // root is exact to the last bit instead of accumulating the error of repeated products.
+    // The tables are shared by all threads and never change or go away once built: a longer
+    // one is added next to the shorter ones, which transforms running elsewhere may still read.
+    // The first n roots of every table are the same, so the longest one serves all sizes.
+    const BigInt::fft_base *fftRoots(size_t n) {
+        static std::mutex mutex;
+        static std::vector<std::unique_ptr<BigInt::fft_base[]>> tables;
+        static size_t longest = 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (longest < n) {
+            std::unique_ptr<BigInt::fft_base[]> roots(new BigInt::fft_base[n]);
+            size_t half = n / 2;
+            for (size_t j = 0; j < half; j++) {
+                double angle = 2 * M_PI * double(j) / double(n);
+                roots[half + j] = BigInt::fft_base(cos(angle), sin(angle));
+            }
+            for (size_t len = half; len >= 2; len /= 2) {
+                for (size_t j = 0; j < len / 2; j++) {
+                    roots[len / 2 + j] = roots[len + 2 * j];
+                }
+            }
+            tables.push_back(std::move(roots));
+            longest = n;
+        }
+        return tables.back().get();
+    }
+
+    const size_t FFT_BLOCK_POINTS = size_t(1) << 13;
+
+    // Butterflies j in [begin, end) of the level of length 2 * half, for every group of 2 * half points in a[0, n)
+    void fftButterflies(BigInt::fft_base *a, size_t n, size_t half, size_t begin, size_t end,
+                        const BigInt::fft_base *roots, bool invert) {
+        for (size_t i = 0; i < n; i += 2 * half) {
+            for (size_t j = begin; j < end; j++) {
+                BigInt::fft_base w = invert ? std::conj(roots[half + j]) : roots[half + j];
+                BigInt::fft_base u = a[i + j];
+                BigInt::fft_base v = complexMultiply(a[i + j + half], w);
+                a[i + j] = u + v;
+                a[i + j + half] = u - v;
+            }
+        }
+    }
+
+    // Transforms over 16-bit pieces, see BigInt::fft.
+    // Convolution terms of a length-n transform reach 2^32 * n, and rounding stays exact while
+    // 2 * FFT_PIECE_BITS + log2(n) <= 50 even for all-ones operands; one bit is kept as a margin.
+    const int FFT_PIECE_BITS = 16;
+    const int FFT_PIECES_PER_LIMB = 64 / FFT_PIECE_BITS;
+    const limb_t FFT_PIECE_MASK = (limb_t(1) << FFT_PIECE_BITS) - 1;
+    const size_t FFT_MAX_EXACT_LENGTH = size_t(1) << 17;
+
+    // Number-theoretic transforms over 32-bit pieces modulo three primes c * 2^k + 1.
+    // Their product exceeds 2^90, while a convolution term of a length-2^26 transform
+    // is below 2^25 * 2^64, so the Chinese remainder reconstruction is always exact.
+    const int NTT_PIECE_BITS = 32;
+    const int NTT_PIECES_PER_LIMB = 64 / NTT_PIECE_BITS;
+    const size_t NTT_MAX_LENGTH = size_t(1) << 26;
+    // Points of the lowest transform levels done block by block, as FFT_BLOCK_POINTS for the FFT
+    const size_t NTT_BLOCK_POINTS = size_t(1) << 15;
+
+    template<uint32_t MOD, uint32_t GENERATOR>
+    struct NttPrime {
+        static const uint32_t modulo = MOD;
+
+        static uint32_t mulMod(uint32_t a, uint32_t b) {
+            return uint32_t(uint64_t(a) * b % MOD);
+        }
+
+        static uint32_t powMod(uint32_t a, uint64_t exp) {
+            uint32_t result = 1;
+            while (exp) {
+                if (exp & 1) {
+                    result = mulMod(result, a);
+                }
+                a = mulMod(a, a);
+                exp >>= 1;
+            }
+            return result;
+        }
+
+        // Same layout and sharing as fftRoots: roots[len / 2 + j] = w_len^j. Roots of a longer table
+        // are powers of those of a shorter one, so its first n entries are exactly the same.
+        static const uint32_t *roots(size_t n) {
+            static std::mutex mutex;
+            static std::vector<std::unique_ptr<uint32_t[]>> tables;
+            static size_t longest = 0;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (longest < n) {
+                std::unique_ptr<uint32_t[]> table(new uint32_t[n]());
+                size_t half = n / 2;
+                uint32_t w = powMod(GENERATOR, (MOD - 1) / n);
+                table[half] = 1;
+                for (size_t j = 1; j < half; j++) {
+                    table[half + j] = mulMod(table[half + j - 1], w);
+                }
+                for (size_t len = half; len >= 2; len /= 2) {
+                    for (size_t j = 0; j < len / 2; j++) {
+                        table[len / 2 + j] = table[len + 2 * j];
+                    }
+                }
+                tables.push_back(std::move(table));
+                longest = n;
+            }
+            return tables.back().get();
+        }
+
+        // Butterflies j in [begin, end) of the level of length 2 * half, for every group of 2 * half points in a[0, n)
+        static void butterflies(uint32_t *a, size_t n, size_t half, size_t begin, size_t end, const uint32_t *w) {
+            for (size_t i = 0; i < n; i += 2 * half) {
+                for (size_t j = begin; j < end; j++) {
+                    uint32_t u = a[i + j];
+                    uint32_t v = mulMod(a[i + j + half], w[half + j]);
+                    a[i + j] = u + v >= MOD ? u + v - MOD : u + v;
+                    a[i + j + half] = u >= v ? u - v : u + MOD - v;
+                }
+            }
+        }
+
+        // The inverse transform is the forward one followed by reversing a[1, n) and scaling by 1/n.
+        // The levels are split among the threads as in BigInt::fft.
+        static void transform(std::vector<uint32_t> &a, bool invert) {
+            size_t n = a.size();
+            for (size_t i = 1, j = 0; i < n; i++) {
+                size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                if (i < j) {
+                    std::swap(a[i], a[j]);
+                }
+            }
+            const uint32_t *w = roots(n);
+            size_t block = std::min(n, NTT_BLOCK_POINTS);
+            BigInt::detail::parallelFor(n / block, 1, [&](size_t begin, size_t end) {
+                for (size_t start = begin * block; start < end * block; start += block) {
+                    for (size_t half = 1; half < block; half *= 2) {
+                        butterflies(&a[start], block, half, 0, half, w);
+                    }
+                }
+            });
+            for (size_t len = 2 * block; len <= n; len *= 2) {
+                size_t half = len / 2;
+                BigInt::detail::parallelFor(half, block / 2, [&](size_t begin, size_t end) {
+                    butterflies(a.data(), n, half, begin, end, w);
+                });
+            }
+            if (invert) {
+                std::reverse(a.begin() + 1, a.end());
+                uint32_t nInverse = powMod(uint32_t(n % MOD), MOD - 2);
+                for (auto &x : a) {
+                    x = mulMod(x, nInverse);
+                }
+            }
+        }
+
+        // Cyclic convolution of left and right, or of left with itself when right is null.
+        static std::vector<uint32_t> convolution(const std::vector<uint32_t> &left, const std::vector<uint32_t> *right) {
+            std::vector<uint32_t> fa(left.size()), fb;
+            for (size_t i = 0; i < left.size(); i++) {
+                fa[i] = left[i] % MOD;
+            }
+            transform(fa, false);
+            if (right != nullptr) {
+                fb.resize(right->size());
+                for (size_t i = 0; i < right->size(); i++) {
+                    fb[i] = (*right)[i] % MOD;
+                }
+                transform(fb, false);
+            }
+            const std::vector<uint32_t> &fr = right != nullptr ? fb : fa;
+            for (size_t i = 0; i < fa.size(); i++) {
+                fa[i] = mulMod(fa[i], fr[i]);
+            }
+            transform(fa, true);
+            return fa;
+        }
+    };
+
+    typedef NttPrime<469762049, 3> NttPrime1;
+    typedef NttPrime<1811939329, 13> NttPrime2;
+    typedef NttPrime<2013265921, 31> NttPrime3;
+
+    void splitToNttPieces(std::vector<uint32_t> &out, const limb_t *a, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            out[2 * i] = uint32_t(a[i]);
+            out[2 * i + 1] = uint32_t(a[i] >> 32);
+        }
+    }
+
+    // Product of two spans, or the square of a when b is null.
+    void nttProduct(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+        size_t pieces = (an + bn) * NTT_PIECES_PER_LIMB;
+        size_t n = 1;
+        while (n < pieces) {
+            n *= 2;
+        }
+        std::vector<uint32_t> left_arg(n), right_arg;
+        splitToNttPieces(left_arg, a, an);
+        if (b != nullptr) {
+            right_arg.resize(n);
+            splitToNttPieces(right_arg, b, bn);
+        }
+        const std::vector<uint32_t> *right = b != nullptr ? &right_arg : nullptr;
+        // The residues modulo the three primes are independent, one task each
+        std::vector<uint32_t> res1, res2, res3;
+        std::function<void()> convolutions[] = {
+                [&] { res1 = NttPrime1::convolution(left_arg, right); },
+                [&] { res2 = NttPrime2::convolution(left_arg, right); },
+                [&] { res3 = NttPrime3::convolution(left_arg, right); },
+        };
+        BigInt::detail::parallelInvoke(convolutions, 3);
+
+        // Garner's reconstruction: x = r1 + p1 * k1 + p1 * p2 * k2
+        const uint32_t p1 = NttPrime1::modulo, p2 = NttPrime2::modulo;
+        const uint32_t p1InverseModP2 = NttPrime2::powMod(p1 % p2, p2 - 2);
+        const uint32_t p1p2ModP3 = NttPrime3::mulMod(p1, p2 % NttPrime3::modulo);
+        const uint32_t p1p2InverseModP3 = NttPrime3::powMod(p1p2ModP3, NttPrime3::modulo - 2);
+        const double_limb_t p1p2 = double_limb_t(p1) * p2;
+
+        std::fill(r, r + an + bn, 0);
+        double_limb_t carry = 0;
+        for (size_t i = 0; i < pieces; i++) {
+            uint32_t x1 = res1[i];
+            uint32_t k1 = NttPrime2::mulMod((res2[i] + p2 - x1 % p2) % p2, p1InverseModP2);
+            uint64_t low = uint64_t(x1) + uint64_t(p1) * k1;
+            uint32_t lowModP3 = uint32_t(low % NttPrime3::modulo);
+            uint32_t k2 = NttPrime3::mulMod((res3[i] + NttPrime3::modulo - lowModP3) % NttPrime3::modulo,
+                                            p1p2InverseModP3);
+            carry += low + p1p2 * k2;
+            r[i / NTT_PIECES_PER_LIMB] |= limb_t(uint32_t(carry)) << (i % NTT_PIECES_PER_LIMB * NTT_PIECE_BITS);
+            carry >>= NTT_PIECE_BITS;
+        }
+    }
+
+    // Schoolbook split into halves, only used beyond the longest supported transform.
+    void mulSplit(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+        size_t h = (an + 1) / 2;
+        if (bn <= h) {
+            LimbBuffer tmp(2 * bn);
+            mulUnbalanced(r, a, an, b, bn, tmp.data(), mulAny);
+            return;
+        }
+        LimbBuffer tmp(2 * h);
+        std::fill(r, r + an + bn, 0);
+        BigInt::detail::mul(r, a, h, b, h);
+        BigInt::detail::mul(r + 2 * h, a + h, an - h, b + h, bn - h);
+        BigInt::detail::mul(tmp.data(), a, h, b + h, bn - h);
+        BigInt::detail::add(r + h, r + h, an + bn - h, tmp.data(), bn);
+        BigInt::detail::mul(tmp.data(), b, h, a + h, an - h);
+        BigInt::detail::add(r + h, r + h, an + bn - h, tmp.data(), an);
+    }
+
+    void splitToPieces(std::vector<BigInt::fft_base> &out, const limb_t *a, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            for (int j = 0; j < FFT_PIECES_PER_LIMB; j++) {
+                out[i * FFT_PIECES_PER_LIMB + j] = double((a[i] >> (j * FFT_PIECE_BITS)) & FFT_PIECE_MASK);
+            }
+        }
+    }
+
+    // Product of two spans, or the square of a when b is null, which saves one forward transform.
+    void fftProduct(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+        std::vector<BigInt::fft_base> left_arg, right_arg;
+        size_t n = 1;
+        while (n < (an + bn) * FFT_PIECES_PER_LIMB) {
+            n *= 2;
+        }
+        std::function<void()> transforms[] = {
+                [&] {
+                    left_arg.resize(n);
+                    splitToPieces(left_arg, a, an);
+                    BigInt::fft(left_arg, false);
+                },
+                [&] {
+                    right_arg.resize(n);
+                    splitToPieces(right_arg, b, bn);
+                    BigInt::fft(right_arg, false);
+                },
+        };
+        BigInt::detail::parallelInvoke(transforms, b != nullptr ? 2 : 1);
+        const std::vector<BigInt::fft_base> &right = b != nullptr ? right_arg : left_arg;
+        for (size_t i = 0; i < n; i++) {
+            left_arg[i] = complexMultiply(left_arg[i], right[i]);
+        }
+        BigInt::fft(left_arg, true);
+
+        std::fill(r, r + an + bn, 0);
+        unsigned long long rem = 0;
+        for (size_t i = 0; i < (an + bn) * FFT_PIECES_PER_LIMB; i++) {
+            unsigned long long cur_res = (unsigned long long)(floor(left_arg[i].real() + 0.5)) + rem;
+            r[i / FFT_PIECES_PER_LIMB] |= limb_t(cur_res & FFT_PIECE_MASK) << (i % FFT_PIECES_PER_LIMB * FFT_PIECE_BITS);
+            rem = cur_res >> FFT_PIECE_BITS;
+        }
+    }
+}
+
+BigInt::MultiplicationThresholds BigInt::getMultiplicationThresholds() {
+    return thresholds;
+}
+
+void BigInt::setMultiplicationThresholds(const BigInt::MultiplicationThresholds &newThresholds) {
+    thresholds = newThresholds;
+}
+
+void BigInt::mpn::mul(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn, limb_t *scratch) {
+    if (bn < thresholds.karatsuba) {
+        detail::mulBasecase(r, a, an, b, bn);
+    } else if (bn < thresholds.toom3) {
+        detail::mulKaratsuba(r, a, an, b, bn, scratch);
+    } else if (bn < thresholds.fft) {
+        detail::mulToom3(r, a, an, b, bn);
+    } else if ((an + bn) * FFT_PIECES_PER_LIMB <= FFT_MAX_EXACT_LENGTH) {
+        detail::mulFFT(r, a, an, b, bn);
+    } else if ((an + bn) * NTT_PIECES_PER_LIMB <= NTT_MAX_LENGTH) {
+        detail::mulNTT(r, a, an, b, bn);
+    } else {
+        mulSplit(r, a, an, b, bn);
+    }
+}
+
+size_t BigInt::mpn::mulScratchSize(size_t an, size_t bn) {
+    // Only Karatsuba products work in caller scratch, and their recursion needs at most 8 an limbs
+    return bn >= thresholds.karatsuba && bn < thresholds.toom3 ? 8 * an + 32 : 0;
+}
+
+void BigInt::mpn::sqr(limb_t *r, const limb_t *a, size_t n, limb_t *scratch) {
+    if (n < thresholds.karatsuba) {
+        detail::sqrBasecase(r, a, n);
+    } else if (n < thresholds.toom3) {
+        detail::sqrKaratsuba(r, a, n, scratch);
+    } else if (n < thresholds.fft) {
+        detail::sqrToom3(r, a, n);
+    } else if (2 * n * FFT_PIECES_PER_LIMB <= FFT_MAX_EXACT_LENGTH) {
+        detail::sqrFFT(r, a, n);
+    } else if (2 * n * NTT_PIECES_PER_LIMB <= NTT_MAX_LENGTH) {
+        detail::sqrNTT(r, a, n);
+    } else {
+        mulSplit(r, a, n, a, n);
+    }
+}
+
+size_t BigInt::mpn::sqrScratchSize(size_t n) {
+    return n >= thresholds.karatsuba && n < thresholds.toom3 ? 8 * n + 32 : 0;
+}
+
+void BigInt::detail::mulBasecase(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    r[an] = mul1(r, a, an, b[0]);
+    for (size_t j = 1; j < bn; j++) {
+        r[an + j] = addMul1(r + j, a, an, b[j]);
+    }
+}
+
+void BigInt::detail::sqrBasecase(limb_t *r, const limb_t *a, size_t n) {
+    // Every cross product a[i] * a[j], i < j, is computed once and doubled afterwards
+    std::fill(r, r + 2 * n, 0);
+    for (size_t i = 0; i + 1 < n; i++) {
+        r[i + n] = addMul1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    limb_t top = 0;
+    for (size_t i = 0; i < 2 * n; i++) {
+        limb_t next = r[i] >> 63;
+        r[i] = (r[i] << 1) | top;
+        top = next;
+    }
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        double_limb_t square = (double_limb_t)a[i] * a[i];
+        double_limb_t low = (double_limb_t)r[2 * i] + (limb_t)square + carry;
+        r[2 * i] = (limb_t)low;
+        double_limb_t high = (double_limb_t)r[2 * i + 1] + (limb_t)(square >> 64) + (limb_t)(low >> 64);
+        r[2 * i + 1] = (limb_t)high;
+        carry = (limb_t)(high >> 64);
+    }
+}
+
+void BigInt::detail::mulKaratsuba(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn, limb_t *ws) {
+    if (ws != nullptr) {
+        karatsuba(r, a, an, b, bn, ws);
+        return;
+    }
+    LimbBuffer buffer(8 * an + 32);
+    karatsuba(r, a, an, b, bn, buffer.data());
+}
+
+void BigInt::detail::sqrKaratsuba(limb_t *r, const limb_t *a, size_t n, limb_t *ws) {
+    if (ws != nullptr) {
+        karatsubaSquare(r, a, n, ws);
+        return;
+    }
+    LimbBuffer buffer(8 * n + 32);
+    karatsubaSquare(r, a, n, buffer.data());
+}
+
+void BigInt::detail::mulToom3(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    size_t k = (an + 2) / 3;
+    if (bn <= 2 * k) {
+        if (bn * 2 <= an) {
+            LimbBuffer tmp(2 * bn);
+            mulUnbalanced(r, a, an, b, bn, tmp.data(), mulAny);
+        } else {
+            mulKaratsuba(r, a, an, b, bn);
+        }
+        return;
+    }
+    Toom3Points pa = toom3Evaluate(a, an, k);
+    Toom3Points pb = toom3Evaluate(b, bn, k);
+    Toom3Points products;
+    std::function<void()> subProducts[] = {
+            [&] { products.p0 = mulSigned(pa.p0, pb.p0); },
+            [&] { products.p1 = mulSigned(pa.p1, pb.p1); },
+            [&] { products.pm1 = mulSigned(pa.pm1, pb.pm1); },
+            [&] { products.pm2 = mulSigned(pa.pm2, pb.pm2); },
+            [&] { products.pinf = mulSigned(pa.pinf, pb.pinf); },
+    };
+    runSubProducts(subProducts, 5, bn);
+    toom3Interpolate(r, an + bn, k, products);
+}
+
+void BigInt::detail::sqrToom3(limb_t *r, const limb_t *a, size_t n) {
+    size_t k = (n + 2) / 3;
+    if (n <= 2 * k) {
+        sqrKaratsuba(r, a, n);
+        return;
+    }
+    Toom3Points points = toom3Evaluate(a, n, k);
+    std::function<void()> subProducts[] = {
+            [&] { points.p0 = sqrSigned(points.p0); },
+            [&] { points.p1 = sqrSigned(points.p1); },
+            [&] { points.pm1 = sqrSigned(points.pm1); },
+            [&] { points.pm2 = sqrSigned(points.pm2); },
+            [&] { points.pinf = sqrSigned(points.pinf); },
+    };
+    runSubProducts(subProducts, 5, n);
+    toom3Interpolate(r, 2 * n, k, points);
+}
+
+void BigInt::detail::mulFFT(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    fftProduct(r, a, an, b, bn);
+}
+
+void BigInt::detail::sqrFFT(limb_t *r, const limb_t *a, size_t n) {
+    fftProduct(r, a, n, nullptr, n);
+}
+
+void BigInt::detail::mulNTT(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    nttProduct(r, a, an, b, bn);
+}
+
+void BigInt::detail::sqrNTT(limb_t *r, const limb_t *a, size_t n) {
+    nttProduct(r, a, n, nullptr, n);
+}
+
+void BigInt::fft(std::vector<BigInt::fft_base> &arg, bool invert) {
+    size_t n = arg.size();
+    if (n <= 1) {
+        return;
+    }
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(arg[i], arg[j]);
+        }
+    }
+
+    // The levels up to FFT_BLOCK_POINTS stay inside blocks of that many points, which are
+    // transformed one after the other while they are in cache, or side by side on the thread pool.
+    // Every longer level splits its butterflies among the threads instead.
+    const BigInt::fft_base *roots = fftRoots(n);
+    size_t block = std::min(n, FFT_BLOCK_POINTS);
+    BigInt::detail::parallelFor(n / block, 1, [&](size_t begin, size_t end) {
+        for (size_t start = begin * block; start < end * block; start += block) {
+            for (size_t half = 1; half < block; half *= 2) {
+                fftButterflies(&arg[start], block, half, 0, half, roots, invert);
+            }
+        }
+    });
+    for (size_t len = 2 * block; len <= n; len *= 2) {
+        size_t half = len / 2;
+        BigInt::detail::parallelFor(half, block / 2, [&](size_t begin, size_t end) {
+            fftButterflies(arg.data(), n, half, begin, end, roots, invert);
+        });
+    }
+    if (invert) {
+        for (auto &x : arg) {
+            x /= double(n);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include "BigIntegerRandom.h"
+
+#include <random>
+
+namespace {
+    std::uint64_t rotateLeft(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // SplitMix64, which spreads a single seed over the whole xoshiro state
+    std::uint64_t splitMix(std::uint64_t &x) {
+        std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+}
+
+BigInt::RandomSource::RandomSource() {
+    std::random_device randomDevice;
+    seed((std::uint64_t(randomDevice()) << 32) ^ randomDevice());
+}
+
+BigInt::RandomSource::RandomSource(std::uint64_t seed) {
+    this->seed(seed);
+}
+
+void BigInt::RandomSource::seed(std::uint64_t seed) {
+    for (std::uint64_t &word : state) {
+        word = splitMix(seed);
+    }
+}
+
+BigInt::limb_t BigInt::RandomSource::operator()() {
+    std::uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+    std::uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotateLeft(state[3], 45);
+    return result;
+}
+
+void BigInt::RandomSource::fill(limb_t *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (*this)();
+    }
+}
+
+BigInt::BigInteger BigInt::RandomSource::randomBits(size_t bits) {
+    BigInt::BigInteger result;
+    if (bits == 0) {
+        return result;
+    }
+    result.data.resize((bits + BigInteger::LIMB_BITS - 1) / BigInteger::LIMB_BITS);
+    fill(result.data.data(), result.data.size());
+    if (bits % BigInteger::LIMB_BITS != 0) {
+        result.data.back() &= (limb_t(1) << (bits % BigInteger::LIMB_BITS)) - 1;
+    }
+    result.cleanup_zeroes();
+    return result;
+}
+
+BigInt::BigInteger BigInt::RandomSource::below(const BigInt::BigInteger &bound) {
+    // Candidates have the bit length of the bound, so each is accepted with probability above 1/2
+    size_t bits = bound.bitLength();
+    while (true) {
+        BigInt::BigInteger candidate = randomBits(bits);
+        if (candidate < bound) {
+            return candidate;
+        }
+    }
+}
+
+BigInt::RandomSource &BigInt::RandomSource::current() {
+    static thread_local RandomSource source;
+    return source;
+}
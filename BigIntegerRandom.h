@@ -0,0 +1,44 @@
+//
+// Random numbers for BigInteger. A RandomSource is a xoshiro256** generator
+// producing whole limbs; every thread has its own current source, seeded from
+// std::random_device on first use or explicitly for reproducible runs:
+//
+//     RandomSource::current().seed(42);
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERRANDOM_H
+#define BIGINTEGERLAB_BIGINTEGERRANDOM_H
+
+#include "BigInteger.h"
+
+namespace BigInt {
+    class RandomSource {
+    public:
+        // Satisfies UniformRandomBitGenerator, so it also works with the <random> distributions
+        typedef limb_t result_type;
+
+        // Seeded from std::random_device
+        RandomSource();
+        explicit RandomSource(std::uint64_t seed);
+
+        void seed(std::uint64_t seed);
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return ~result_type(0); }
+        result_type operator()();
+
+        void fill(limb_t *out, size_t n);
+        // Uniform in [0, 2^bits)
+        BigInteger randomBits(size_t bits);
+        // Uniform in [0, bound) by rejection, bound must be positive
+        BigInteger below(const BigInteger &bound);
+
+        // The source of the calling thread
+        static RandomSource &current();
+
+    private:
+        std::uint64_t state[4];
+    };
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERRANDOM_H
@@ -0,0 +1,231 @@
+#include "BigIntegerThreadPool.h"
+#include "BigInteger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Tasks of one parallelInvoke call, living on the stack of the caller until all are done
+    struct TaskGroup {
+        std::atomic<size_t> pending{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    struct Task {
+        const std::function<void()> *body;
+        TaskGroup *group;
+    };
+
+    const size_t NOT_A_WORKER = ~size_t(0);
+    thread_local size_t workerIndex = NOT_A_WORKER;
+
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t workers) {
+            for (size_t i = 0; i < workers; i++) {
+                queues.emplace_back(new Queue());
+            }
+            for (size_t i = 0; i < workers; i++) {
+                threads.emplace_back([this, i] { work(i); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void run(const std::function<void()> *tasks, size_t n) {
+            TaskGroup group;
+            group.pending.store(n, std::memory_order_relaxed);
+            // The calling thread keeps the first task and offers the others
+            for (size_t i = 1; i < n; i++) {
+                push({&tasks[i], &group});
+            }
+            execute({&tasks[0], &group});
+            while (group.pending.load(std::memory_order_acquire) != 0) {
+                if (runOne()) {
+                    continue;
+                }
+                // Nothing to help with: sleep until a task is queued or the last one of the group is done
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wake.wait(lock, [this, &group] {
+                    return queued.load(std::memory_order_acquire) != 0 ||
+                           group.pending.load(std::memory_order_acquire) == 0;
+                });
+            }
+            if (group.error) {
+                std::rethrow_exception(group.error);
+            }
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> queued{0};
+        std::atomic<size_t> nextQueue{0};
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        void push(const Task &task) {
+            // Workers fill their own deque, other threads spread their tasks round robin
+            size_t index = workerIndex != NOT_A_WORKER ? workerIndex
+                                                       : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+            {
+                std::lock_guard<std::mutex> lock(queues[index]->mutex);
+                queues[index]->tasks.push_back(task);
+            }
+            queued.fetch_add(1, std::memory_order_release);
+            // Taking the lock orders the push before the check of a thread about to sleep.
+            // Workers and waiting callers share the condition, and a caller whose group has just
+            // finished may leave without taking the task, so all of them are woken.
+            { std::lock_guard<std::mutex> lock(sleepMutex); }
+            wake.notify_all();
+        }
+
+        void execute(const Task &task) {
+            try {
+                (*task.body)();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(task.group->errorMutex);
+                if (!task.group->error) {
+                    task.group->error = std::current_exception();
+                }
+            }
+            // The group may be gone right after the last task is counted, so only the pool is touched then
+            if (task.group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                { std::lock_guard<std::mutex> lock(sleepMutex); }
+                wake.notify_all();
+            }
+        }
+
+        bool pop(Queue &queue, bool newest, Task &task) {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                return false;
+            }
+            if (newest) {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            } else {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Runs the newest own task, or else steals the oldest one of another queue
+        bool runOne() {
+            Task task{};
+            size_t self = workerIndex;
+            bool found = self != NOT_A_WORKER && pop(*queues[self], true, task);
+            size_t start = self != NOT_A_WORKER ? self + 1 : 0;
+            for (size_t k = 0; !found && k < queues.size(); k++) {
+                found = pop(*queues[(start + k) % queues.size()], false, task);
+            }
+            if (found) {
+                execute(task);
+            }
+            return found;
+        }
+
+        void work(size_t index) {
+            workerIndex = index;
+            while (true) {
+                if (runOne()) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) != 0; });
+                if (stopping) {
+                    return;
+                }
+            }
+        }
+    };
+
+    unsigned hardwareThreads() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::mutex poolMutex;
+    unsigned threadCount = 0;
+    std::unique_ptr<ThreadPool> threadPool;
+
+    // Started on the first parallel call, so programs that never multiply huge numbers get no threads
+    ThreadPool *pool() {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (threadCount == 0) {
+            threadCount = hardwareThreads();
+        }
+        if (threadCount > 1 && !threadPool) {
+            threadPool.reset(new ThreadPool(threadCount - 1));
+        }
+        return threadPool.get();
+    }
+}
+
+void BigInt::setMultiplicationThreads(unsigned threads) {
+    // The old pool is joined after the lock is released
+    std::unique_ptr<ThreadPool> previous;
+    std::lock_guard<std::mutex> lock(poolMutex);
+    threadCount = threads != 0 ? threads : hardwareThreads();
+    previous = std::move(threadPool);
+}
+
+unsigned BigInt::getMultiplicationThreads() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return threadCount != 0 ? threadCount : hardwareThreads();
+}
+
+void BigInt::detail::parallelInvoke(const std::function<void()> *tasks, size_t n) {
+    ThreadPool *threads = n > 1 ? pool() : nullptr;
+    if (threads == nullptr) {
+        for (size_t i = 0; i < n; i++) {
+            tasks[i]();
+        }
+        return;
+    }
+    threads->run(tasks, n);
+}
+
+void BigInt::detail::parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)> &body) {
+    // A few pieces per thread, so stealing can even out pieces that take longer
+    size_t threads = getMultiplicationThreads();
+    size_t pieces = threads > 1 ? std::min(n / std::max<size_t>(grain, 1), 4 * threads) : 1;
+    if (pieces <= 1) {
+        body(0, n);
+        return;
+    }
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(pieces);
+    for (size_t i = 0; i < pieces; i++) {
+        size_t begin = n * i / pieces, end = n * (i + 1) / pieces;
+        tasks.emplace_back([&body, begin, end] { body(begin, end); });
+    }
+    parallelInvoke(tasks.data(), pieces);
+}
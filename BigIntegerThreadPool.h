@@ -0,0 +1,27 @@
+//
+// Internal thread pool that splits single large multiplications across cores.
+// Every worker keeps its own deque of tasks: it runs the newest of its own first
+// and steals the oldest of another worker's when it runs out. A thread waiting for
+// its tasks keeps running queued ones meanwhile, so tasks may start tasks of their own,
+// and sleeps when there are none left to run.
+// The number of threads is set by setMultiplicationThreads in BigInteger.h.
+//
+
+#ifndef BIGINTEGERLAB_BIGINTEGERTHREADPOOL_H
+#define BIGINTEGERLAB_BIGINTEGERTHREADPOOL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace BigInt {
+    namespace detail {
+        // Runs tasks[0, n) on the pool and the calling thread and returns once all have finished.
+        // The first exception thrown by a task is rethrown here.
+        void parallelInvoke(const std::function<void()> *tasks, size_t n);
+
+        // body(begin, end) for pieces of [0, n) with at least grain elements each
+        void parallelFor(size_t n, size_t grain, const std::function<void(size_t, size_t)> &body);
+    }
+}
+
+#endif //BIGINTEGERLAB_BIGINTEGERTHREADPOOL_H
@@ -213,7 +213,7 @@ void Interface::processAddition(const std::vector<std::string>& args) {
     BigInteger leftArg, rightArg, modulo;
     parseArgsToBigInts(args, leftArg, rightArg, modulo);
     BigInteger result = leftArg + rightArg;
-    if (modulo != BigInteger(0)) {
+    if (!modulo.isZero()) {
         outputStream << result % modulo;
     } else {
         outputStream << result;
@@ -228,7 +228,7 @@ void Interface::processSubtraction(const std::vector<std::string> &args) {
     BigInteger leftArg, rightArg, modulo;
     parseArgsToBigInts(args, leftArg, rightArg, modulo);
     BigInteger result = leftArg - rightArg;
-    if (modulo != BigInteger(0)) {
+    if (!modulo.isZero()) {
         outputStream << result % modulo;
     } else {
         outputStream << result;
@@ -243,7 +243,7 @@ void Interface::processMultiplication(const std::vector<std::string> &args){
     BigInteger leftArg, rightArg, modulo;
     parseArgsToBigInts(args, leftArg, rightArg, modulo);
     BigInteger result = leftArg * rightArg;
-    if (modulo != BigInteger(0)) {
+    if (!modulo.isZero()) {
         outputStream << result % modulo;
     } else {
         outputStream << result;
@@ -258,7 +258,7 @@ void Interface::processDivision(const std::vector<std::string> &args){
     BigInteger leftArg, rightArg, modulo;
     parseArgsToBigInts(args, leftArg, rightArg, modulo);
     BigInteger result = leftArg / rightArg;
-    if (modulo != BigInteger(0)) {
+    if (!modulo.isZero()) {
         outputStream << result % modulo;
     } else {
         outputStream << result;
@@ -283,7 +283,7 @@ void Interface::processPower(const std::vector<std::string> &args) {
 
     BigInteger leftArg, rightArg, modulo;
     parseArgsToBigInts(args, leftArg, rightArg, modulo);
-    if (modulo != BigInteger(0)) {
+    if (!modulo.isZero()) {
         outputStream << leftArg.pow(rightArg, modulo);
     } else {
         outputStream << leftArg.pow(rightArg);
@@ -0,0 +1,48 @@
+//
+// Three threads multiply FFT- and NTT-sized numbers of different lengths at the same time, so their
+// transforms share the thread pool and may run each other's tasks while they wait.
+// Every product must equal the one computed before by a single thread.
+//
+
+#include "../BigInteger.h"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+    BigInt::setMultiplicationThreads(4);
+    const int ROUNDS = 4;
+    // Lengths in bits: the first two products take the FFT, the second with a four times longer
+    // transform, and the third is past the FFT limit and takes the NTT
+    const int BITS[] = {270000, 900000, 1500000};
+
+    std::vector<BigInt::BigInteger> lhs, rhs, expected;
+    for (int bits : BITS) {
+        lhs.push_back(BigInt::BigInteger::getRandOfBitLen(bits));
+        rhs.push_back(BigInt::BigInteger::getRandOfBitLen(bits));
+        expected.push_back(lhs.back() * rhs.back());
+    }
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < expected.size(); t++) {
+        threads.emplace_back([&, t] {
+            for (int round = 0; round < ROUNDS; round++) {
+                if (lhs[t] * rhs[t] != expected[t] || lhs[t].square() != lhs[t] * lhs[t]) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    if (failures != 0) {
+        std::cerr << failures << " concurrent products differ from the serial ones" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+//
+// The default curve over FixedBigInteger<128> must give the same points as over BigInteger,
+// and those points must stay on the curve of the base point and add up as the group law says.
+// The default base point does not satisfy the default b, so the curve is taken through it;
+// addition never uses b.
+//
+
+#include "../BigIntegerAlgorithm.h"
+#include "../BigIntegerRandom.h"
+
+#include <iostream>
+
+namespace {
+    typedef BigInt::FixedBigInteger<128> Fixed;
+    typedef BigInt::BasicEllipticCurve<Fixed> FixedCurve;
+
+    // y^2 - x^3 - a x, the b of the curve through the point
+    BigInt::BigInteger curveB(const BigInt::EllipticCurve &curve, const BigInt::EllipticCurve::Point &point) {
+        const BigInt::BigInteger &x = point.getX(), &y = point.getY();
+        return (y * y - x * x * x - curve.getA() * x) % curve.getP();
+    }
+
+    bool samePoint(const BigInt::EllipticCurve::Point &big, const FixedCurve::Point &fixed) {
+        return big.getX() == fixed.getX().toBigInteger() && big.getY() == fixed.getY().toBigInteger();
+    }
+}
+
+int main() {
+    BigInt::EllipticCurve bigCurve;
+    FixedCurve fixedCurve;
+    BigInt::EllipticCurve::Point bigBase = bigCurve.createPoint();
+    FixedCurve::Point fixedBase = fixedCurve.createPoint();
+    BigInt::BigInteger baseB = curveB(bigCurve, bigBase);
+    BigInt::RandomSource::current().seed(25);
+
+    int failures = 0;
+    for (int i = 0; i < 50; i++) {
+        BigInt::BigInteger k = BigInt::BigInteger::rand(bigCurve.getP());
+        BigInt::BigInteger m = BigInt::BigInteger::rand(bigCurve.getP());
+        BigInt::EllipticCurve::Point bigK = bigBase * k, bigM = bigBase * m;
+        FixedCurve::Point fixedK = fixedBase * k, fixedM = fixedBase * m;
+        if (!samePoint(bigK, fixedK) || !samePoint(bigK + bigM, fixedK + fixedM) ||
+            !samePoint(bigK + bigK, fixedK + fixedK)) {
+            failures++;
+        }
+        if (curveB(bigCurve, bigK) != baseB || curveB(bigCurve, bigK + bigK) != baseB ||
+            !(bigK + bigM == bigBase * (k + m))) {
+            failures++;
+        }
+    }
+
+    if (failures != 0) {
+        std::cerr << failures << " curve checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
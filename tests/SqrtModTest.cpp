@@ -0,0 +1,44 @@
+//
+// sqrtMod must return a root of every quadratic residue modulo an odd prime,
+// -1 for non-residues and even moduli, and must not loop forever on 2.
+//
+
+#include "../BigIntegerAlgorithm.h"
+#include "../BigIntegerRandom.h"
+
+#include <iostream>
+
+int main() {
+    BigInt::RandomSource::current().seed(18);
+    int failures = 0;
+
+    BigInt::BigInteger small = BigInt::sqrtMod(BigInt::BigInteger(2), BigInt::BigInteger(7));
+    if (small != BigInt::BigInteger(3) && small != BigInt::BigInteger(4)) {
+        failures++;
+    }
+    if (BigInt::sqrtMod(BigInt::BigInteger(3), BigInt::BigInteger(7)) != BigInt::BigInteger(-1) ||
+        BigInt::sqrtMod(BigInt::BigInteger(1), BigInt::BigInteger(2)) != BigInt::BigInteger(-1)) {
+        failures++;
+    }
+
+    for (int bits : {16, 64, 127, 200}) {
+        for (int i = 0; i < 15; i++) {
+            BigInt::BigInteger p = BigInt::BigInteger::getRandOfBitLen(bits) | BigInt::BigInteger(1);
+            while (!BigInt::isPrime(p)) {
+                p += BigInt::BigInteger(2);
+            }
+            BigInt::BigInteger x = BigInt::BigInteger::rand(p - BigInt::BigInteger(1)) + BigInt::BigInteger(1);
+            BigInt::BigInteger residue = x.square() % p;
+            BigInt::BigInteger root = BigInt::sqrtMod(residue, p);
+            if (root.signum() < 0 || root.square() % p != residue) {
+                failures++;
+            }
+        }
+    }
+
+    if (failures != 0) {
+        std::cerr << failures << " square roots modulo primes are wrong" << std::endl;
+        return 1;
+    }
+    return 0;
+}